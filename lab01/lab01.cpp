@@ -1,6 +1,8 @@
 //bubbleSort = repeatedly swaps the adjacent elements if they are in wrong order
 //insertionSort = takes the i+1th element and places it in the correct place
 //selectionSort = repeatedly finds the minimum element from unsorted part and puts it at the beginning of the same unsorted part
+//smallSort = insertionSort replacement for short runs: sorting networks (AVX2) or branchless compare-exchanges
+//*SortRange = the same three sorts over any random access range, with a comparator and a key projection
 
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
@@ -8,8 +10,32 @@
 
 #include <iostream>
 #include <time.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <limits.h>
+#include <iterator>
+#include <utility>
+#include <stdlib.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #define MAXN 1501
+#define BENCH_RUNS 31
+#define NR_PERF_EVENTS 4
+#define SMALL_BATCH 1000
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 int bubbleC = 0;
 int bubbleA = 0;
@@ -20,57 +46,273 @@ int insertionA = 0;
 int selectionC = 0;
 int selectionA = 0;
 
+//operation counting policies: CountOps adds to the global counters, NoOps compiles to nothing,
+//so the NoOps instantiation of a sort has no stores to the counters in its inner loops
+//build with -DNO_OP_COUNT to make NoOps the default everywhere (the csv counts are then 0)
+
+struct CountOps {
+	static void add(int& counter, int value) { counter = counter + value; }
+};
+
+struct NoOps {
+	static void add(int&, int) {}
+};
+
+#ifdef NO_OP_COUNT
+typedef NoOps DefaultOps;
+#else
+typedef CountOps DefaultOps;
+#endif
+
+template <class Ops = DefaultOps>
 void bubbleSort(int arr[], int arrSize) {
 	bool cont = false;
 	do {
 		cont = false;
 		for (int j = 0; j < arrSize - 1; j++) {
-			bubbleC++;
+			Ops::add(bubbleC, 1);
 			if (arr[j] > arr[j + 1]) {
 				cont = true;
 				std::swap(arr[j], arr[j + 1]);
-				bubbleA = bubbleA + 3;
+				Ops::add(bubbleA, 3);
 			}
 		}
 	} while (cont == true);
 }
 
+template <class Ops = DefaultOps>
 void insertionSort(int arr[], int arrSize) {
 	int j, buff;
 	for (int i = 1; i < arrSize; i++) {
 		buff = arr[i];
-		insertionA++;
+		Ops::add(insertionA, 1);
 		j = i - 1;
 		while (j >= 0 && arr[j] > buff) {
-			insertionC++;
+			Ops::add(insertionC, 1);
 			arr[j + 1] = arr[j];
-			insertionA++;
+			Ops::add(insertionA, 1);
 			j--;
 		}
-		insertionC++;
+		Ops::add(insertionC, 1);
 		arr[j + 1] = buff;
-		insertionA++;
+		Ops::add(insertionA, 1);
 	}
 }
 
+template <class Ops = DefaultOps>
 void selectionSort(int arr[], int arrSize)
 {
 	int imin;
 	for (int i = 0; i < arrSize - 1; i++) {
 		imin = i;
 		for (int j = i + 1; j <= arrSize - 1; j++) {
-			selectionC++;
+			Ops::add(selectionC, 1);
 			if (arr[j] < arr[imin]) {
 				imin = j;
 			}
 		}
 		if (i != imin) {
 			std::swap(arr[i], arr[imin]);
-			selectionA = selectionA + 3;
+			Ops::add(selectionA, 3);
+		}
+	}
+}
+
+//small runs: the same (int arr[], int arrSize) signature as insertionSort, meant for tens of elements
+
+//every step is a compare-exchange done with conditional moves, so there is no data-dependent branch
+//to mispredict, at the price of always doing n*(n-1)/2 compare-exchanges
+void branchlessInsertionSort(int arr[], int arrSize) {
+	for (int i = 1; i < arrSize; i++) {
+		for (int j = i; j > 0; j--) {
+			int a = arr[j - 1];
+			int b = arr[j];
+			bool greater = a > b;
+			arr[j - 1] = greater ? b : a;
+			arr[j] = greater ? a : b;
+		}
+	}
+}
+
+#ifdef __AVX2__
+//compare-exchange of every lane with its partner lane, the lanes set in Mask keep the max
+template <int Mask>
+inline __m256i compareExchange8(__m256i v, __m256i partner) {
+	return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), Mask);
+}
+
+inline __m256i reverse8(__m256i v) {
+	return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+//sorts a bitonic register: half-cleaners at distance 4, 2, 1
+inline __m256i bitonicMerge8(__m256i v) {
+	v = compareExchange8<0xF0>(v, _mm256_permute2x128_si256(v, v, 0x01));
+	v = compareExchange8<0xCC>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = compareExchange8<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return v;
+}
+
+//bitonic sorting network of 8 ints in one register
+inline __m256i sortNetwork8(__m256i v) {
+	v = compareExchange8<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	v = compareExchange8<0xCC>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+	v = compareExchange8<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	v = compareExchange8<0xF0>(v, reverse8(v));
+	v = compareExchange8<0xCC>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = compareExchange8<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return v;
+}
+
+//a, b sorted => a holds the 8 smallest, b the 8 largest, both sorted
+inline void bitonicMerge16(__m256i& a, __m256i& b) {
+	__m256i rb = reverse8(b);
+	__m256i lo = _mm256_min_epi32(a, rb);
+	__m256i hi = _mm256_max_epi32(a, rb);
+	a = bitonicMerge8(lo);
+	b = bitonicMerge8(hi);
+}
+
+//arrSize <= 32: the run is padded with INT_MAX up to 8, 16 or 32 elements and sorted in registers
+void sortNetwork(int arr[], int arrSize) {
+	alignas(32) int buff[32];
+	int width = arrSize <= 8 ? 8 : (arrSize <= 16 ? 16 : 32);
+	for (int i = 0; i < arrSize; i++) {
+		buff[i] = arr[i];
+	}
+	for (int i = arrSize; i < width; i++) {
+		buff[i] = INT_MAX;
+	}
+
+	__m256i v[4];
+	for (int i = 0; i < width / 8; i++) {
+		v[i] = sortNetwork8(_mm256_load_si256((__m256i*)(buff + 8 * i)));
+	}
+	if (width >= 16) {
+		bitonicMerge16(v[0], v[1]);
+	}
+	if (width == 32) {
+		bitonicMerge16(v[2], v[3]);
+
+		//merge the two sorted halves (v[0], v[1]) and (v[2], v[3])
+		__m256i r3 = reverse8(v[3]);
+		__m256i r2 = reverse8(v[2]);
+		__m256i lo0 = _mm256_min_epi32(v[0], r3);
+		__m256i hi0 = _mm256_max_epi32(v[0], r3);
+		__m256i lo1 = _mm256_min_epi32(v[1], r2);
+		__m256i hi1 = _mm256_max_epi32(v[1], r2);
+		v[0] = bitonicMerge8(_mm256_min_epi32(lo0, lo1));
+		v[1] = bitonicMerge8(_mm256_max_epi32(lo0, lo1));
+		v[2] = bitonicMerge8(_mm256_min_epi32(hi0, hi1));
+		v[3] = bitonicMerge8(_mm256_max_epi32(hi0, hi1));
+	}
+
+	for (int i = 0; i < width / 8; i++) {
+		_mm256_store_si256((__m256i*)(buff + 8 * i), v[i]);
+	}
+	for (int i = 0; i < arrSize; i++) {
+		arr[i] = buff[i];
+	}
+}
+#endif
+
+void smallSort(int arr[], int arrSize) {
+#ifdef __AVX2__
+	if (arrSize <= 32) {
+		sortNetwork(arr, arrSize);
+		return;
+	}
+#endif
+	branchlessInsertionSort(arr, arrSize);
+}
+
+//generic sorts: records are moved (never copied), compared through comp(proj(a), proj(b))
+
+struct Identity {
+	template <class T>
+	const T& operator()(const T& x) const { return x; }
+};
+
+struct Less {
+	template <class A, class B>
+	bool operator()(const A& a, const B& b) const { return a < b; }
+};
+
+//the larger element is carried in a temporary along the pass: 1 move per step instead of the 3 of a swap
+//everything after the last exchange of a pass is in place, so the next pass stops there
+template <class It, class Compare = Less, class Proj = Identity>
+void bubbleSortRange(It first, It last, Compare comp = Compare(), Proj proj = Proj()) {
+	typedef typename std::iterator_traits<It>::value_type T;
+	It end = last;
+	while (end - first > 1) {
+		It lastExchange = first;
+		T carried = std::move(*first);
+		It j = first;
+		for (It next = first + 1; next != end; ++next) {
+			if (comp(proj(*next), proj(carried))) {
+				*j = std::move(*next);
+				lastExchange = next;
+			}
+			else {
+				*j = std::move(carried);
+				carried = std::move(*next);
+			}
+			j = next;
+		}
+		*j = std::move(carried);
+		end = lastExchange;
+	}
+}
+
+//shifts the greater elements one position right and writes the inserted element once
+template <class It, class Compare = Less, class Proj = Identity>
+void insertionSortRange(It first, It last, Compare comp = Compare(), Proj proj = Proj()) {
+	typedef typename std::iterator_traits<It>::value_type T;
+	if (first == last) {
+		return;
+	}
+	for (It i = first + 1; i != last; ++i) {
+		if (!comp(proj(*i), proj(*(i - 1)))) {
+			continue;
+		}
+		T buff = std::move(*i);
+		It j = i;
+		do {
+			*j = std::move(*(j - 1));
+			--j;
+		} while (j != first && comp(proj(buff), proj(*(j - 1))));
+		*j = std::move(buff);
+	}
+}
+
+//selection already does the minimum number of writes (one exchange per position)
+template <class It, class Compare = Less, class Proj = Identity>
+void selectionSortRange(It first, It last, Compare comp = Compare(), Proj proj = Proj()) {
+	for (It i = first; last - i > 1; ++i) {
+		It imin = i;
+		for (It j = i + 1; j != last; ++j) {
+			if (comp(proj(*j), proj(*imin))) {
+				imin = j;
+			}
+		}
+		if (imin != i) {
+			std::iter_swap(i, imin);
 		}
 	}
 }
 
+//64-bit key + payload, Bytes in total
+template <int Bytes>
+struct Record {
+	long long key;
+	char payload[Bytes - sizeof(long long)];
+};
+
+struct RecordKey {
+	template <class R>
+	long long operator()(const R& r) const { return r.key; }
+};
+
 void showArr(int arr[], int arrSize) {
 	for (int i = 0; i < arrSize; i++) {
 		printf("%d ", arr[i]);
@@ -78,8 +320,443 @@ void showArr(int arr[], int arrSize) {
 	printf("\n\n");
 }
 
-int main()
+//benchmark: wall-clock time of each sort over BENCH_RUNS runs and hardware counters (Linux perf_event)
+//the counters are -1 when perf_event is not available (other OS, perf_event_paranoid, virtual machines)
+
+typedef void (*SortFunc)(int arr[], int arrSize);
+
+struct PerfCounters {
+	int fd[NR_PERF_EVENTS];
+	long long values[NR_PERF_EVENTS];
+};
+
+void perfOpen(PerfCounters* pc) {
+#ifdef __linux__
+	unsigned long long configs[NR_PERF_EVENTS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES };
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = configs[i];
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		pc->fd[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#else
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		pc->fd[i] = -1;
+	}
+#endif
+}
+
+void perfStart(PerfCounters* pc) {
+#ifdef __linux__
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		if (pc->fd[i] >= 0) {
+			ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+void perfStop(PerfCounters* pc) {
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		pc->values[i] = -1;
+#ifdef __linux__
+		if (pc->fd[i] >= 0) {
+			ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+			if (read(pc->fd[i], &pc->values[i], sizeof(long long)) != sizeof(long long)) {
+				pc->values[i] = -1;
+			}
+		}
+#endif
+	}
+}
+
+void perfClose(PerfCounters* pc) {
+#ifdef __linux__
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		if (pc->fd[i] >= 0) {
+			close(pc->fd[i]);
+		}
+	}
+#endif
+}
+
+//nearest-rank percentile, p in [0, 1]
+long long percentile(std::vector<long long>& v, double p) {
+	std::sort(v.begin(), v.end());
+	return v[(size_t)(p * (v.size() - 1) + 0.5)];
+}
+
+//one csv row: the operation counts of a single run next to the median/p99 time and the median hardware counters
+//countedSort fills the counters, timedSort (the NoOps instantiation) is the one that is timed
+void benchSort(FILE* fout, PerfCounters* pc, const char* caseName, const char* sortName, SortFunc countedSort,
+	SortFunc timedSort, int* opsA, int* opsC, const std::vector<int>& src) {
+	int arrSize = (int)src.size();
+	std::vector<int> work(src);
+
+	*opsA = 0;
+	*opsC = 0;
+	countedSort(work.data(), arrSize);
+	int assignments = *opsA;
+	int comparisons = *opsC;
+
+	std::vector<long long> ns(BENCH_RUNS);
+	std::vector<long long> counters[NR_PERF_EVENTS];
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		work = src;
+		perfStart(pc);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		timedSort(work.data(), arrSize);
+		std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+		perfStop(pc);
+		ns[r] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+		for (int i = 0; i < NR_PERF_EVENTS; i++) {
+			counters[i].push_back(pc->values[i]);
+		}
+	}
+
+	fprintf(fout, "%d,%s,%s,%d,%d,%d,", arrSize, caseName, sortName, assignments, comparisons, assignments + comparisons);
+	fprintf(fout, "%lld,%lld", percentile(ns, 0.5), percentile(ns, 0.99));
+	for (int i = 0; i < NR_PERF_EVENTS; i++) {
+		fprintf(fout, ",%lld", percentile(counters[i], 0.5));
+	}
+	fprintf(fout, "\n");
+}
+
+//short runs take tens of ns, so every timed run sorts SMALL_BATCH different arrays
+//and the reported time is per array
+void benchSmallSort(FILE* fout, const char* sortName, SortFunc sort, int arrSize) {
+	std::vector<int> src(SMALL_BATCH * arrSize);
+	for (size_t i = 0; i < src.size(); i++) {
+		src[i] = rand() % MAXN;
+	}
+
+	std::vector<int> work(src.size());
+	std::vector<long long> ns(BENCH_RUNS);
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		work = src;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int b = 0; b < SMALL_BATCH; b++) {
+			sort(work.data() + b * arrSize, arrSize);
+		}
+		std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+		ns[r] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+	}
+	fprintf(fout, "%d,%s,%.2f,%.2f\n", arrSize, sortName, (double)percentile(ns, 0.5) / SMALL_BATCH,
+		(double)percentile(ns, 0.99) / SMALL_BATCH);
+}
+
+struct BubbleRange {
+	template <class It, class Compare, class Proj>
+	void operator()(It first, It last, Compare comp, Proj proj) const { bubbleSortRange(first, last, comp, proj); }
+};
+
+struct InsertionRange {
+	template <class It, class Compare, class Proj>
+	void operator()(It first, It last, Compare comp, Proj proj) const { insertionSortRange(first, last, comp, proj); }
+};
+
+struct SelectionRange {
+	template <class It, class Compare, class Proj>
+	void operator()(It first, It last, Compare comp, Proj proj) const { selectionSortRange(first, last, comp, proj); }
+};
+
+template <class R, class SortRange>
+void benchRecordSort(FILE* fout, const char* sortName, SortRange sort, const std::vector<R>& src) {
+	std::vector<R> work(src);
+	std::vector<long long> ns(BENCH_RUNS);
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		work = src;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		sort(work.begin(), work.end(), Less(), RecordKey());
+		std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+		ns[r] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+	}
+	fprintf(fout, "%d,%d,%s,%lld,%lld\n", (int)sizeof(R), (int)src.size(), sortName, percentile(ns, 0.5), percentile(ns, 0.99));
+}
+
+template <int Bytes>
+void benchRecords(FILE* fout, int n) {
+	std::vector<Record<Bytes> > src(n);
+	for (int i = 0; i < n; i++) {
+		src[i].key = ((long long)rand() << 32) ^ rand();
+		memset(src[i].payload, i & 0xFF, sizeof(src[i].payload));
+	}
+	benchRecordSort(fout, "bubble", BubbleRange(), src);
+	benchRecordSort(fout, "insertion", InsertionRange(), src);
+	benchRecordSort(fout, "selection", SelectionRange(), src);
+}
+
+void runBenchmarks() {
+	FILE* fout;
+	fout = fopen("lab2_bench.csv", "w+");
+	fprintf(fout, "N,Case,Sort,Assignments,Comparisons,Total,Median ns,P99 ns,Cycles,Instructions,Branch misses,Cache misses\n");
+
+	PerfCounters pc;
+	perfOpen(&pc);
+	if (pc.fd[0] < 0) {
+		printf("perf_event not available, hardware counters are reported as -1\n");
+	}
+
+	const char* caseNames[] = { "average", "best", "worst" };
+	srand((unsigned int)time(NULL));
+	for (int arrSize = 500; arrSize < 1500; arrSize = arrSize + 100) {
+		std::vector<int> src(arrSize);
+		for (int c = 0; c < 3; c++) {
+			for (int i = 0; i < arrSize; i++) {
+				if (c == 0) {
+					src[i] = rand() % MAXN;
+				}
+				else if (c == 1) {
+					src[i] = i;
+				}
+				else {
+					src[i] = arrSize - i;
+				}
+			}
+			benchSort(fout, &pc, caseNames[c], "bubble", bubbleSort<CountOps>, bubbleSort<NoOps>,
+				&bubbleA, &bubbleC, src);
+			benchSort(fout, &pc, caseNames[c], "insertion", insertionSort<CountOps>, insertionSort<NoOps>,
+				&insertionA, &insertionC, src);
+			benchSort(fout, &pc, caseNames[c], "selection", selectionSort<CountOps>, selectionSort<NoOps>,
+				&selectionA, &selectionC, src);
+		}
+	}
+
+	perfClose(&pc);
+	fclose(fout);
+
+	fout = fopen("lab2_small.csv", "w+");
+	fprintf(fout, "N,Sort,Median ns per array,P99 ns per array\n");
+	int smallSizes[] = { 8, 12, 16, 24, 32, 48, 64 };
+	for (int arrSize : smallSizes) {
+		benchSmallSort(fout, "insertion", insertionSort<NoOps>, arrSize);
+		benchSmallSort(fout, "branchless insertion", branchlessInsertionSort, arrSize);
+		benchSmallSort(fout, "smallSort", smallSort, arrSize);
+	}
+	fclose(fout);
+
+	fout = fopen("lab2_records.csv", "w+");
+	fprintf(fout, "Record bytes,N,Sort,Median ns,P99 ns\n");
+	for (int n = 250; n <= 1000; n = n + 250) {
+		benchRecords<16>(fout, n);
+		benchRecords<64>(fout, n);
+		benchRecords<256>(fout, n);
+	}
+	fclose(fout);
+}
+
+//scalable driver: lab01 --run [--n N] [--dist D] [--sort S] [--seed X] [--runs R]
+//	- buffers are heap allocated (huge pages on Linux when available), so N is only limited by memory
+//	- the data comes from a seeded xoshiro256** generator, so a run can be reproduced from its seed
+
+//xoshiro256**, seeded through splitmix64
+struct Xoshiro256 {
+	unsigned long long s[4];
+};
+
+unsigned long long splitMix64(unsigned long long* x) {
+	unsigned long long z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void xoshiroSeed(Xoshiro256* rng, unsigned long long seed) {
+	for (int i = 0; i < 4; i++) {
+		rng->s[i] = splitMix64(&seed);
+	}
+}
+
+unsigned long long rotl64(unsigned long long x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+unsigned long long xoshiroNext(Xoshiro256* rng) {
+	unsigned long long* s = rng->s;
+	unsigned long long result = rotl64(s[1] * 5, 7) * 9;
+	unsigned long long t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl64(s[3], 45);
+	return result;
+}
+
+enum Distribution {
+	DIST_RANDOM,
+	DIST_SORTED,
+	DIST_REVERSE,
+	DIST_FEW_UNIQUE,
+	DIST_ORGAN_PIPE,
+	NR_DISTRIBUTIONS
+};
+
+const char* distributionNames[NR_DISTRIBUTIONS] = { "random", "sorted", "reverse", "few-unique", "organ-pipe" };
+
+void fillArray(int arr[], long long arrSize, Distribution dist, Xoshiro256* rng) {
+	for (long long i = 0; i < arrSize; i++) {
+		switch (dist) {
+		case DIST_RANDOM:
+			arr[i] = (int)(xoshiroNext(rng) >> 33);
+			break;
+		case DIST_SORTED:
+			arr[i] = (int)i;
+			break;
+		case DIST_REVERSE:
+			arr[i] = (int)(arrSize - i);
+			break;
+		case DIST_FEW_UNIQUE:
+			arr[i] = (int)(xoshiroNext(rng) >> 60);
+			break;
+		default:
+			arr[i] = (int)(i < arrSize / 2 ? i : arrSize - i);
+			break;
+		}
+	}
+}
+
+//huge pages: explicit (MAP_HUGETLB) when the system has reserved some, transparent (MADV_HUGEPAGE) otherwise
+int* allocBuffer(long long arrSize) {
+	size_t bytes = (size_t)arrSize * sizeof(int);
+#ifdef __linux__
+	size_t mapped = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	void* ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (ptr == MAP_FAILED) {
+		ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) {
+			return NULL;
+		}
+		madvise(ptr, mapped, MADV_HUGEPAGE);
+	}
+	return (int*)ptr;
+#else
+	return (int*)malloc(bytes);
+#endif
+}
+
+void freeBuffer(int* arr, long long arrSize) {
+#ifdef __linux__
+	size_t bytes = (size_t)arrSize * sizeof(int);
+	munmap(arr, (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+#else
+	free(arr);
+#endif
+}
+
+int runDriver(int argc, char* argv[]) {
+	long long arrSize = 100000;
+	Distribution dist = DIST_RANDOM;
+	const char* sortName = "all";
+	unsigned long long seed = 1;
+	int runs = 3;
+
+	const char* sortNames[] = { "bubble", "insertion", "selection", "small" };
+	SortFunc sorts[] = { bubbleSort<NoOps>, insertionSort<NoOps>, selectionSort<NoOps>, smallSort };
+	const int nrSorts = (int)(sizeof(sortNames) / sizeof(sortNames[0]));
+	const char* options[] = { "--n", "--dist", "--sort", "--seed", "--runs" };
+	for (int i = 2; i < argc; i++) {
+		bool known = false;
+		for (int o = 0; o < (int)(sizeof(options) / sizeof(options[0])); o++) {
+			known = known || strcmp(argv[i], options[o]) == 0;
+		}
+		if (!known) {
+			printf("unknown option %s\n", argv[i]);
+			return 1;
+		}
+		if (i + 1 >= argc) {
+			printf("missing value for %s\n", argv[i]);
+			return 1;
+		}
+		if (strcmp(argv[i], "--n") == 0) {
+			arrSize = atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--dist") == 0) {
+			i++;
+			int d = 0;
+			while (d < NR_DISTRIBUTIONS && strcmp(argv[i], distributionNames[d]) != 0) {
+				d++;
+			}
+			if (d == NR_DISTRIBUTIONS) {
+				printf("unknown distribution %s\n", argv[i]);
+				return 1;
+			}
+			dist = (Distribution)d;
+		}
+		else if (strcmp(argv[i], "--sort") == 0) {
+			sortName = argv[++i];
+			int t = 0;
+			while (t < nrSorts && strcmp(sortName, sortNames[t]) != 0) {
+				t++;
+			}
+			if (t == nrSorts && strcmp(sortName, "all") != 0) {
+				printf("unknown sort %s\n", sortName);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--seed") == 0) {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else {
+			runs = atoi(argv[++i]);
+		}
+	}
+	if (arrSize < 1 || arrSize > INT_MAX || runs < 1) {
+		printf("invalid --n or --runs\n");
+		return 1;
+	}
+
+	int* src = allocBuffer(arrSize);
+	int* work = allocBuffer(arrSize);
+	if (src == NULL || work == NULL) {
+		printf("can't allocate %lld elements\n", arrSize);
+		return 1;
+	}
+	Xoshiro256 rng;
+	xoshiroSeed(&rng, seed);
+	fillArray(src, arrSize, dist, &rng);
+
+	printf("N,Distribution,Seed,Sort,Median ns,P99 ns\n");
+	for (int s = 0; s < nrSorts; s++) {
+		if (strcmp(sortName, "all") != 0 && strcmp(sortName, sortNames[s]) != 0) {
+			continue;
+		}
+		std::vector<long long> ns(runs);
+		for (int r = 0; r < runs; r++) {
+			memcpy(work, src, (size_t)arrSize * sizeof(int));
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			sorts[s](work, (int)arrSize);
+			std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+			ns[r] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+		}
+		printf("%lld,%s,%llu,%s,%lld,%lld\n", arrSize, distributionNames[dist], seed, sortNames[s],
+			percentile(ns, 0.5), percentile(ns, 0.99));
+	}
+
+	freeBuffer(src, arrSize);
+	freeBuffer(work, arrSize);
+	return 0;
+}
+
+int main(int argc, char* argv[])
 {
+	//timing mode, writes lab2_bench.csv instead of the operation-count charts
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		runBenchmarks();
+		return 0;
+	}
+	if (argc > 1 && strcmp(argv[1], "--run") == 0) {
+		return runDriver(argc, argv);
+	}
+
 	FILE* fout;
 	fout = fopen("lab2.csv", "w+");
 	fprintf(fout, "N,Bubble assignment,Bubble comparisons,Bubble total,Insertion assignment,Insertion comparisons,Insertion total,Selection assignment,Selection comparisons,Selection total,Bubble assignment,Bubble comparisons,Bubble total,Insertion assignment,Insertion comparisons,Insertion total,Selection assignment,Selection comparisons,Selection total,Bubble assignment,Bubble comparisons,Bubble total,Insertion assignment,Insertion comparisons,Insertion total,Selection assignment,Selection comparisons,Selection total\n");
@@ -167,4 +844,12 @@ int main()
 	showArr(arrSelect, n);
 	selectionSort(arrSelect, n);
 	showArr(arrSelect, n);
+
+	printf("Proof of corectness small sort:\n");
+	for (int i = 0; i < n; i++) {
+		arrInsert[i] = rand() % MAXN;
+	}
+	showArr(arrInsert, n);
+	smallSort(arrInsert, n);
+	showArr(arrInsert, n);
 }
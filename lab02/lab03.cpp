@@ -10,6 +10,30 @@
 	Comparison: 
 				The BU method works better because it has to work with only n/2 elements (n/2 are already heaps), while 
 			TD method works with all n elements
+
+	3. Parallel Bottom-Up:
+		-the subtrees rooted at the nodes of the same level are disjoint => they can be heapified at the same time
+		-the levels are processed from the deepest one up to the root, each level split between the threads of a pool
+		-the levels with less than PAR_THRESHOLD nodes (the top of the tree) are heapified sequentially
+
+	4. D-ary heap (DaryHeap<T, D, Compare>):
+		-every node has D children => the tree has log_D(n) levels instead of log_2(n)
+		-the D children of a node are next to each other and start on a cache line boundary,
+		so a sift-down step costs one cache miss for all the children
+		-sift-down does D - 1 comparisons per level, sift-up (top-down build) only 1, over fewer levels
+
+	5. Priority queue (PriorityQueue<T, Compare>):
+		-push = swimTD of the new last element, pop = move the last element to the root and heapifyBU it
+		-every pushed key gets a handle, the queue keeps the heap position of each handle => changeKey/decreaseKey in O(log n)
+		-pushBulk only appends; the next operation either swims the new elements or rebuilds bottom-up (O(n)),
+		whichever is cheaper
+
+	6. Fast heapsort (heapSortFast):
+		-4-ary max heap in place, rooted at the first element that lies FAST_SHIFT ints after a cache line
+		boundary: the 4 children of a node are one aligned 16 byte SIMD load and the 16 grandchildren are exactly
+		one cache line, which is prefetched while the children are compared
+		-the max among the children is found with SSE4.1 (max + compare + movemask), scalar when not available
+		-the (at most 15) elements before the root are sorted apart and merged in front at the end => O(1) extra memory
 */
 
 #ifdef _MSC_VER
@@ -18,32 +42,72 @@
 
 #include <iostream>
 #include <time.h>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <stdint.h>
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#define HAVE_SSE41
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define PREFETCH(p) __builtin_prefetch(p)
+#endif
 
 #define MAXN 5001
+#define PAR_THRESHOLD 4096
+#define BENCH_RUNS 3
+#define CACHE_LINE 64
+#define FAST_SHIFT 11
 
 int operationsBU = 0;
 int operationsTD = 0;
 
+//Floyd's sift-down: the root element is lifted into a "hole" that is moved down along the larger children
+//to a leaf (1 comparison per level), then the element is sifted up from there and written only once
+//operations: 1 per comparison and 1 per assignment (a move of the hole instead of a 3-assignment swap)
 void heapifyBU(int arr[], int arrSize, int root) {
-	int largest = root;
-	int leftChildInd = 2 * root + 1;
-	int rightChildInd = 2 * root + 2;
-
+	int buff = arr[root];
 	operationsBU++;
-	if (leftChildInd < arrSize && arr[leftChildInd] > arr[largest]) {
-		largest = leftChildInd;
-	}
+	int hole = root;
+	int child = 2 * hole + 1;
 
-	operationsBU++;
-	if (rightChildInd < arrSize && arr[rightChildInd] > arr[largest]) {
-		largest = rightChildInd;
+	while (child < arrSize) {
+		if (child + 1 < arrSize) {
+			operationsBU++;
+			if (arr[child + 1] > arr[child]) {
+				child++;
+			}
+		}
+		arr[hole] = arr[child];
+		operationsBU++;
+		hole = child;
+		child = 2 * hole + 1;
 	}
 
-	if (largest != root) {
-		std::swap(arr[largest], arr[root]);
-		operationsBU = operationsBU + 3;
-		heapifyBU(arr, arrSize, largest);
+	while (hole > root) {
+		int parent = (hole - 1) / 2;
+		operationsBU++;
+		if (arr[parent] >= buff) {
+			break;
+		}
+		arr[hole] = arr[parent];
+		operationsBU++;
+		hole = parent;
 	}
+	arr[hole] = buff;
+	operationsBU++;
 }
 
 void buildHeapBU(int arr[], int arrSize) {
@@ -79,6 +143,698 @@ void heapSort(int arr[], int arrSize) {
 	}
 }
 
+//parallel bottom-up build
+
+//fixed set of worker threads; the calling thread takes the first chunk of every parallelFor
+class ThreadPool {
+public:
+	explicit ThreadPool(int nrThreads) : job(NULL), jobBegin(0), jobEnd(0), generation(0), pending(0), stop(false) {
+		for (int i = 1; i < nrThreads; i++) {
+			threads.push_back(std::thread(&ThreadPool::worker, this, i));
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m);
+			stop = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+
+	int size() const {
+		return (int)threads.size() + 1;
+	}
+
+	//body(chunkBegin, chunkEnd) for size() equal chunks of [begin, end), returns when all of them are done
+	void parallelFor(int begin, int end, const std::function<void(int, int)>& body) {
+		{
+			std::lock_guard<std::mutex> lock(m);
+			job = &body;
+			jobBegin = begin;
+			jobEnd = end;
+			pending = (int)threads.size();
+			generation++;
+		}
+		wake.notify_all();
+		runChunk(0, body, begin, end);
+
+		std::unique_lock<std::mutex> lock(m);
+		done.wait(lock, [this] { return pending == 0; });
+	}
+
+private:
+	void runChunk(int id, const std::function<void(int, int)>& body, int begin, int end) {
+		long long len = end - begin;
+		int chunkBegin = begin + (int)(len * id / size());
+		int chunkEnd = begin + (int)(len * (id + 1) / size());
+		if (chunkBegin < chunkEnd) {
+			body(chunkBegin, chunkEnd);
+		}
+	}
+
+	void worker(int id) {
+		int seen = 0;
+		while (true) {
+			std::unique_lock<std::mutex> lock(m);
+			wake.wait(lock, [this, seen] { return stop || generation != seen; });
+			if (stop) {
+				return;
+			}
+			seen = generation;
+			const std::function<void(int, int)>* body = job;
+			int begin = jobBegin;
+			int end = jobEnd;
+			lock.unlock();
+
+			runChunk(id, *body, begin, end);
+
+			lock.lock();
+			if (--pending == 0) {
+				done.notify_one();
+			}
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex m;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(int, int)>* job;
+	int jobBegin;
+	int jobEnd;
+	int generation;
+	int pending;
+	bool stop;
+};
+
+//heapifyBU's Floyd sift-down without the (shared) operation counter; the hole never leaves the subtree of root,
+//so the threads that sift disjoint subtrees of one level don't touch each other's elements
+void siftDownPar(int arr[], int arrSize, int root) {
+	int buff = arr[root];
+	int hole = root;
+	int child = 2 * hole + 1;
+
+	while (child < arrSize) {
+		if (child + 1 < arrSize && arr[child + 1] > arr[child]) {
+			child++;
+		}
+		arr[hole] = arr[child];
+		hole = child;
+		child = 2 * hole + 1;
+	}
+
+	while (hole > root) {
+		int parent = (hole - 1) / 2;
+		if (arr[parent] >= buff) {
+			break;
+		}
+		arr[hole] = arr[parent];
+		hole = parent;
+	}
+	arr[hole] = buff;
+}
+
+void buildHeapBUParallel(int arr[], int arrSize, ThreadPool& pool) {
+	int lastInternal = (arrSize / 2) - 1;
+	if (lastInternal < 0) {
+		return;
+	}
+
+	//level d holds the nodes 2^d - 1 .. 2^(d+1) - 2
+	int depth = 0;
+	while ((2LL << depth) - 1 <= lastInternal) {
+		depth++;
+	}
+	for (int d = depth; d >= 0; d--) {
+		int levelBegin = (1 << d) - 1;
+		int levelEnd = std::min((int)((2LL << d) - 1), lastInternal + 1);
+		if (pool.size() == 1 || levelEnd - levelBegin < PAR_THRESHOLD) {
+			for (int i = levelEnd - 1; i >= levelBegin; i--) {
+				siftDownPar(arr, arrSize, i);
+			}
+		}
+		else {
+			pool.parallelFor(levelBegin, levelEnd, [arr, arrSize](int chunkBegin, int chunkEnd) {
+				for (int i = chunkEnd - 1; i >= chunkBegin; i--) {
+					siftDownPar(arr, arrSize, i);
+				}
+			});
+		}
+	}
+}
+
+//d-ary heap
+
+//the children of node i are D * i + 1 .. D * i + D; node 0 is stored D - 1 positions after a CACHE_LINE
+//boundary, so every group of children starts at a multiple of D from that boundary
+//Compare works like for std::priority_queue: comp(a, b) == true means b goes above a (std::less => max-heap)
+template <class T, int D, class Compare = std::less<T> >
+class DaryHeap {
+public:
+	DaryHeap(const T* src, int n, Compare comp = Compare())
+		: storage(n + D - 1 + CACHE_LINE / sizeof(T) + 1), heapSize(n), comp(comp) {
+		int shift = 0;
+		if (CACHE_LINE % sizeof(T) == 0) {
+			while (shift < (int)(CACHE_LINE / sizeof(T)) && (uintptr_t)(storage.data() + shift) % CACHE_LINE != 0) {
+				shift++;
+			}
+			if (shift == (int)(CACHE_LINE / sizeof(T))) {
+				shift = 0;
+			}
+		}
+		a = storage.data() + shift + D - 1;
+		for (int i = 0; i < n; i++) {
+			a[i] = src[i];
+		}
+	}
+
+	DaryHeap(const DaryHeap&) = delete;
+	DaryHeap& operator=(const DaryHeap&) = delete;
+
+	int size() const {
+		return heapSize;
+	}
+
+	const T& operator[](int i) const {
+		return a[i];
+	}
+
+	const T& top() const {
+		return a[0];
+	}
+
+	void pop() {
+		heapSize--;
+		if (heapSize > 0) {
+			a[0] = std::move(a[heapSize]);
+			siftDown(0);
+		}
+	}
+
+	//heapify the nodes that have children, from the last one to the root
+	void buildBU() {
+		for (int i = (heapSize - 2) / D; i >= 0; i--) {
+			siftDown(i);
+		}
+	}
+
+	//swim every node, the heap grows from 1 element to heapSize
+	void buildTD() {
+		for (int i = 1; i < heapSize; i++) {
+			siftUp(i);
+		}
+	}
+
+	bool isHeap() const {
+		for (int i = 1; i < heapSize; i++) {
+			if (comp(a[(i - 1) / D], a[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	void siftDown(int i) {
+		T buff = std::move(a[i]);
+		while (true) {
+			int first = D * i + 1;
+			if (first >= heapSize) {
+				break;
+			}
+			int last = std::min(first + D, heapSize);
+			int best = first;
+			for (int c = first + 1; c < last; c++) {
+				if (comp(a[best], a[c])) {
+					best = c;
+				}
+			}
+			if (!comp(buff, a[best])) {
+				break;
+			}
+			a[i] = std::move(a[best]);
+			i = best;
+		}
+		a[i] = std::move(buff);
+	}
+
+	void siftUp(int i) {
+		T buff = std::move(a[i]);
+		while (i > 0 && comp(a[(i - 1) / D], buff)) {
+			a[i] = std::move(a[(i - 1) / D]);
+			i = (i - 1) / D;
+		}
+		a[i] = std::move(buff);
+	}
+
+	std::vector<T> storage;
+	T* a;
+	int heapSize;
+	Compare comp;
+};
+
+//priority queue with handles
+
+//Compare works like for std::priority_queue: std::less => max-queue, std::greater => min-queue
+//handles are given in push order (0, 1, 2, ...) and are never reused, so they can be vertex ids in graph code
+template <class T, class Compare = std::less<T> >
+class PriorityQueue {
+public:
+	explicit PriorityQueue(Compare comp = Compare()) : heapified(0), comp(comp) {
+	}
+
+	void reserve(int n) {
+		heap.reserve(n);
+		pos.reserve(n);
+	}
+
+	int size() const {
+		return (int)heap.size();
+	}
+
+	bool empty() const {
+		return heap.empty();
+	}
+
+	//true while the handle is in the queue (pushed and not popped yet)
+	bool contains(int handle) const {
+		return handle >= 0 && handle < (int)pos.size() && pos[handle] >= 0;
+	}
+
+	const T& key(int handle) {
+		fix();
+		return heap[pos[handle]].key;
+	}
+
+	int push(const T& key) {
+		fix();
+		int handle = (int)pos.size();
+		pos.push_back((int)heap.size());
+		heap.push_back(Item(key, handle));
+		heapified++;
+		siftUp((int)heap.size() - 1);
+		return handle;
+	}
+
+	//appends without restoring the heap order, returns the handle of keys[0] (the next ones are consecutive)
+	int pushBulk(const T* keys, int n) {
+		int first = (int)pos.size();
+		//grow only when the capacity runs out, and at least double it, so repeated small bulks stay amortized O(1);
+		//pos also keeps the handles of popped items, so it is sized from its own length
+		if (heap.size() + n > heap.capacity()) {
+			heap.reserve(std::max(heap.size() + n, 2 * heap.capacity()));
+		}
+		if (pos.size() + n > pos.capacity()) {
+			pos.reserve(std::max(pos.size() + n, 2 * pos.capacity()));
+		}
+		for (int i = 0; i < n; i++) {
+			pos.push_back((int)heap.size());
+			heap.push_back(Item(keys[i], first + i));
+		}
+		return first;
+	}
+
+	const T& top() {
+		fix();
+		return heap[0].key;
+	}
+
+	int topHandle() {
+		fix();
+		return heap[0].handle;
+	}
+
+	void pop() {
+		fix();
+		pos[heap[0].handle] = -1;
+		if (heap.size() > 1) {
+			heap[0] = std::move(heap.back());
+			pos[heap[0].handle] = 0;
+		}
+		heap.pop_back();
+		heapified = (int)heap.size();
+		if (!heap.empty()) {
+			siftDown(0);
+		}
+	}
+
+	//the new key must not be below the old one in Compare order (a smaller key for a min-queue), only swims
+	void decreaseKey(int handle, const T& key) {
+		fix();
+		int i = pos[handle];
+		heap[i].key = key;
+		siftUp(i);
+	}
+
+	//any new key, moves the element up or down
+	void changeKey(int handle, const T& key) {
+		fix();
+		int i = pos[handle];
+		bool up = comp(heap[i].key, key);
+		heap[i].key = key;
+		if (up) {
+			siftUp(i);
+		}
+		else {
+			siftDown(i);
+		}
+	}
+
+private:
+	struct Item {
+		T key;
+		int handle;
+		Item(const T& key, int handle) : key(key), handle(handle) {
+		}
+	};
+
+	//restores the heap after pushBulk: m swims cost ~m * log2(n), a bottom-up rebuild ~2n
+	void fix() {
+		int n = (int)heap.size();
+		int m = n - heapified;
+		if (m == 0) {
+			return;
+		}
+		int levels = 1;
+		while ((1LL << levels) < n) {
+			levels++;
+		}
+		if ((long long)m * levels > 2LL * n) {
+			for (int i = (n / 2) - 1; i >= 0; i--) {
+				siftDown(i);
+			}
+		}
+		else {
+			for (int i = heapified; i < n; i++) {
+				siftUp(i);
+			}
+		}
+		heapified = n;
+	}
+
+	void place(Item& item, int i) {
+		heap[i] = std::move(item);
+		pos[heap[i].handle] = i;
+	}
+
+	void siftUp(int i) {
+		Item buff = std::move(heap[i]);
+		while (i > 0 && comp(heap[(i - 1) / 2].key, buff.key)) {
+			place(heap[(i - 1) / 2], i);
+			i = (i - 1) / 2;
+		}
+		place(buff, i);
+	}
+
+	void siftDown(int i) {
+		int n = (int)heap.size();
+		Item buff = std::move(heap[i]);
+		while (2 * i + 1 < n) {
+			int child = 2 * i + 1;
+			if (child + 1 < n && comp(heap[child].key, heap[child + 1].key)) {
+				child++;
+			}
+			if (!comp(buff.key, heap[child].key)) {
+				break;
+			}
+			place(heap[child], i);
+			i = child;
+		}
+		place(buff, i);
+	}
+
+	std::vector<Item> heap;
+	std::vector<int> pos;
+	int heapified;
+	Compare comp;
+};
+
+//fast heapsort
+
+//index of the largest of 4 ints at a 16 byte aligned address (the first one when there are equal ones)
+inline int maxIndex4(const int* p) {
+#ifdef HAVE_SSE41
+	__m128i v = _mm_load_si128((const __m128i*)p);
+	__m128i m = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+	int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, m)));
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, (unsigned long)mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+#else
+	int best = 0;
+	for (int c = 1; c < 4; c++) {
+		if (p[c] > p[best]) {
+			best = c;
+		}
+	}
+	return best;
+#endif
+}
+
+//places x in the hole at node i of the 4-ary heap h[0 .. heapSize)
+//with node 0 at FAST_SHIFT ints after a cache line boundary, the children of i (4i+1 .. 4i+4) start at a
+//multiple of 4 ints and the grandchildren (16i+5 .. 16i+20) fill exactly one cache line
+void siftDownFast(int h[], int heapSize, int i, int x) {
+	while (true) {
+		int first = 4 * i + 1;
+		if (first + 3 < heapSize) {
+			if (16 * i + 5 < heapSize) {
+				PREFETCH(&h[16 * i + 5]);
+			}
+			int best = first + maxIndex4(&h[first]);
+			if (h[best] <= x) {
+				break;
+			}
+			h[i] = h[best];
+			i = best;
+		}
+		else {
+			//last, incomplete group of children
+			int best = -1;
+			for (int c = first; c < heapSize; c++) {
+				if (h[c] > x && (best < 0 || h[c] > h[best])) {
+					best = c;
+				}
+			}
+			if (best >= 0) {
+				h[i] = h[best];
+				i = best;
+			}
+			break;
+		}
+	}
+	h[i] = x;
+}
+
+//for the short arrays of heapSortFast and the part before its heap
+void insertionSort(int arr[], int arrSize) {
+	for (int i = 1; i < arrSize; i++) {
+		int x = arr[i];
+		int j = i - 1;
+		while (j >= 0 && arr[j] > x) {
+			arr[j + 1] = arr[j];
+			j--;
+		}
+		arr[j + 1] = x;
+	}
+}
+
+void heapSortFast(int arr[], int arrSize) {
+	//shorter than a cache line of ints: the aligned heap could be empty (shift can be up to 15)
+	if (arrSize < (int)(CACHE_LINE / sizeof(int))) {
+		insertionSort(arr, arrSize);
+		return;
+	}
+	//the heap is h = arr[shift .. arrSize), with h at FAST_SHIFT ints after a cache line boundary
+	//shift < CACHE_LINE / sizeof(int) <= arrSize => at least 1 element in the heap
+	int shift = 0;
+	while (((uintptr_t)(arr + shift) + CACHE_LINE - FAST_SHIFT * sizeof(int)) % CACHE_LINE != 0) {
+		shift++;
+	}
+	int* h = arr + shift;
+	int heapSize = arrSize - shift;
+
+	for (int i = (heapSize - 2) / 4; i >= 0; i--) {
+		siftDownFast(h, heapSize, i, h[i]);
+	}
+	for (int last = heapSize - 1; last >= 1; last--) {
+		int x = h[last];
+		h[last] = h[0];
+		siftDownFast(h, last, 0, x);
+	}
+
+	//merge the sorted prefix with the sorted heap part; the write position never passes the read position
+	int prefix[CACHE_LINE / sizeof(int)];
+	memcpy(prefix, arr, shift * sizeof(int));
+	insertionSort(prefix, shift);
+	int p = 0;
+	int r = shift;
+	int out = 0;
+	while (p < shift) {
+		if (r < arrSize && arr[r] < prefix[p]) {
+			arr[out++] = arr[r++];
+		}
+		else {
+			arr[out++] = prefix[p++];
+		}
+	}
+}
+
+bool isMaxHeap(int arr[], int arrSize) {
+	for (int i = 1; i < arrSize; i++) {
+		if (arr[(i - 1) / 2] < arr[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//scaling of the parallel build: lab3_parallel.csv with the median time of BENCH_RUNS builds
+void benchParallelBuild(int maxN) {
+	FILE* fout;
+	fout = fopen("lab3_parallel.csv", "w+");
+	fprintf(fout, "N,Threads,Median ms\n");
+
+	int threadCounts[] = { 1, 2, 4, 8, 16 };
+	srand((unsigned int)time(NULL));
+	for (long long n = 1000000; n <= maxN; n = n * 10) {
+		int arrSize = (int)n;
+		std::vector<int> src(arrSize);
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand());
+		}
+		std::vector<int> work(arrSize);
+
+		for (int threads : threadCounts) {
+			ThreadPool pool(threads);
+			std::vector<double> ms(BENCH_RUNS);
+			for (int r = 0; r < BENCH_RUNS; r++) {
+				work = src;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				buildHeapBUParallel(work.data(), arrSize, pool);
+				std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+				ms[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+			}
+			if (!isMaxHeap(work.data(), arrSize)) {
+				printf("parallel build with %d threads is not a heap\n", threads);
+			}
+			std::sort(ms.begin(), ms.end());
+			fprintf(fout, "%d,%d,%.3f\n", arrSize, threads, ms[BENCH_RUNS / 2]);
+			printf("N = %d, %d threads: %.3f ms\n", arrSize, threads, ms[BENCH_RUNS / 2]);
+		}
+	}
+	fclose(fout);
+}
+
+template <int D>
+void benchDaryHeap(FILE* fout, const std::vector<int>& src) {
+	int arrSize = (int)src.size();
+	double msBU[BENCH_RUNS];
+	double msTD[BENCH_RUNS];
+	double msPop = 0;
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		DaryHeap<int, D> heapBU(src.data(), arrSize);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		heapBU.buildBU();
+		std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+		msBU[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+
+		DaryHeap<int, D> heapTD(src.data(), arrSize);
+		start = std::chrono::steady_clock::now();
+		heapTD.buildTD();
+		stop = std::chrono::steady_clock::now();
+		msTD[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+
+		if (!heapBU.isHeap() || !heapTD.isHeap()) {
+			printf("%d-ary build is not a heap\n", D);
+		}
+
+		//extracting everything is where the number of levels (and the cache misses) matter most
+		if (r == 0) {
+			start = std::chrono::steady_clock::now();
+			while (heapBU.size() > 0) {
+				heapBU.pop();
+			}
+			stop = std::chrono::steady_clock::now();
+			msPop = std::chrono::duration<double, std::milli>(stop - start).count();
+		}
+	}
+	std::sort(msBU, msBU + BENCH_RUNS);
+	std::sort(msTD, msTD + BENCH_RUNS);
+	fprintf(fout, "%d,%d,%.3f,%.3f,%.3f\n", arrSize, D, msBU[BENCH_RUNS / 2], msTD[BENCH_RUNS / 2], msPop);
+	printf("N = %d, D = %d: BU %.3f ms, TD %.3f ms, pop all %.3f ms\n", arrSize, D, msBU[BENCH_RUNS / 2],
+		msTD[BENCH_RUNS / 2], msPop);
+}
+
+//lab3_dary.csv: median build times and the time of n pops for D = 2, 4, 8
+void benchDaryHeaps(int maxN) {
+	FILE* fout;
+	fout = fopen("lab3_dary.csv", "w+");
+	fprintf(fout, "N,D,Bottom-up ms,Top-down ms,Pop all ms\n");
+
+	for (long long n = 1000000; n <= maxN; n = n * 10) {
+		std::vector<int> src((size_t)n);
+		for (size_t i = 0; i < src.size(); i++) {
+			src[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand());
+		}
+		benchDaryHeap<2>(fout, src);
+		benchDaryHeap<4>(fout, src);
+		benchDaryHeap<8>(fout, src);
+	}
+	fclose(fout);
+}
+
+//lab3_heapsort.csv: throughput of heapSort vs heapSortFast
+void benchHeapSorts(int maxN) {
+	FILE* fout;
+	fout = fopen("lab3_heapsort.csv", "w+");
+	fprintf(fout, "N,Sort,Median ms,Elements per second\n");
+
+	const char* sortNames[] = { "heapSort", "heapSortFast" };
+	void (*sorts[])(int[], int) = { heapSort, heapSortFast };
+	for (long long n = 1000000; n <= maxN; n = n * 10) {
+		int arrSize = (int)n;
+		std::vector<int> src(arrSize);
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand());
+		}
+		std::vector<int> work(arrSize);
+		for (int s = 0; s < 2; s++) {
+			std::vector<double> ms(BENCH_RUNS);
+			for (int r = 0; r < BENCH_RUNS; r++) {
+				work = src;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				sorts[s](work.data(), arrSize);
+				std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+				ms[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+			}
+			if (!std::is_sorted(work.begin(), work.end())) {
+				printf("%s did not sort the array\n", sortNames[s]);
+			}
+			std::sort(ms.begin(), ms.end());
+			double median = ms[BENCH_RUNS / 2];
+			fprintf(fout, "%d,%s,%.3f,%.0f\n", arrSize, sortNames[s], median, arrSize / (median / 1000));
+			printf("N = %d, %s: %.3f ms, %.0f elements/s\n", arrSize, sortNames[s], median, arrSize / (median / 1000));
+		}
+	}
+	fclose(fout);
+}
+
+void runBenchmarks(int maxN) {
+	benchParallelBuild(maxN);
+	benchDaryHeaps(maxN);
+	benchHeapSorts(maxN);
+}
+
 void showArr(int arr[], int arrSize) {
 	for (int i = 0; i < arrSize; i++) {
 		printf("%d ", arr[i]);
@@ -86,7 +842,13 @@ void showArr(int arr[], int arrSize) {
 	printf("\n");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+	//lab03 --bench [maxN]: timing of the parallel build for N = 10^6 .. maxN (default 10^8)
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		runBenchmarks(argc > 2 ? atoi(argv[2]) : 100000000);
+		return 0;
+	}
+
 	FILE* fout;
 	fout = fopen("lab3.csv", "w+");
 	fprintf(fout, "N,Bottom-up Operations,Top-down Operations,Bottom-up Operations,Top-down Operations\n");
@@ -155,4 +917,22 @@ int main() {
 	showArr(arrBU, n);
 	heapSort(arrBU, n);
 	showArr(arrBU, n);
+	printf("\n");
+
+	printf("Proof of corectness for the priority queue (min-queue, the key of the first element decreased to -1):\n");
+	for (int i = 0; i < n; i++) {
+		arrBU[i] = rand() % 100;
+	}
+	showArr(arrBU, n);
+	PriorityQueue<int, std::greater<int> > pq;
+	int first = pq.pushBulk(arrBU, n / 2);
+	for (int i = n / 2; i < n; i++) {
+		pq.push(arrBU[i]);
+	}
+	pq.decreaseKey(first, -1);
+	while (!pq.empty()) {
+		printf("%d ", pq.top());
+		pq.pop();
+	}
+	printf("\n");
 }
\ No newline at end of file
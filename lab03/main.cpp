@@ -16,6 +16,64 @@
             - worst case: when the partition function always chooses the pivot in a way that one partition always has a single element
             this can happen if we take a sorted array in descending order and always choosing arr[arrSize - 1] as the pivot
             - in the worst case, many assignments because of the partitioning
+
+    IntroSort (quicksort + heapsort + insertion sort):
+            - pivot = median of three (left, middle, right), or the ninther (median of three medians) for big ranges
+            - recursion only into the smaller partition, the larger one is handled by the loop => O(log n) stack
+            - after 2 * log2(n) levels of partitioning the range goes to heapsort => O(n * log n) worst case
+            - ranges of at most INSERTION_CUTOFF elements are left to insertion sort
+
+    Partition modes (quickSortMode, same pivot = median of three for all of them):
+            - Lomuto: 1 swap for every element <= pivot => up to 3 * n assignments, branchy on random data
+            - Hoare: scans from both ends and swaps only the pairs that are on the wrong side => ~n/2 swaps at most
+            - three-way (Dutch flag): < pivot | == pivot | > pivot, the equal keys are done => fast on many duplicates
+            - block (BlockQuicksort): the comparisons of a block of BLOCK_SIZE elements only store offsets,
+            without branches, then the misplaced pairs are swapped => no mispredictions from the comparisons
+
+    Adaptive sort (adaptiveSort, pattern-defeating quicksort):
+            - one scan up front finds the runs: a single ascending run is returned as it is, descending runs
+            (at least INSERTION_CUTOFF long) are reversed => sorted and reverse inputs in O(n)
+            - a partition that swapped nothing suggests a sorted range: both sides get an insertion sort that gives
+            up after PARTIAL_INSERTION_LIMIT moves => presorted ranges are done in linear time
+            - a partition with a side under 1/8 of the range swaps a few elements around to break the pattern,
+            after log2(n) of those the range goes to heapsort => O(n * log n) worst case
+            - when the pivot equals the element before the range, the equal keys are split off (three-way)
+
+    Parallel quicksort (ParallelQuickSort):
+            - top levels: ranges above PAR_PARTITION_MIN are three-way partitioned by all the threads at once
+            (count < / == / > per chunk, prefix sums, scatter into a buffer, copy back)
+            - then every thread has a deque of ranges: it partitions its range (Hoare), pushes the right side
+            to its deque and goes on with the left side; an idle thread steals the oldest (largest) range of another
+            - ranges below PAR_SEQ_CUTOFF are sorted with introsort on the thread that holds them
+
+    Selection (nthElement, multiSelect):
+            - like randomizedSelect, but in place and iterative: median of three pivot + three-way partition,
+            continue only in the side that holds the rank
+            - after two partitions in a row that keep more than 3/4 of the range, the pivot is the median of medians
+            (groups of 5) => O(n) guaranteed, not only expected
+            - multiSelect finds several ranks (for ex. p50/p90/p99) in one pass: the ranks are split between the
+            two sides of every partition, a side without ranks is never touched again
+
+    Radix sort (no comparisons, the keys are the 32 bits of the ints, with the sign bit flipped):
+            - LSD: 4 passes of 8 bits or 3 passes of 11 bits, stable scatter into a buffer; the histograms of all
+            the digits are counted in a single pass, a digit that is the same for all the elements is skipped
+            - MSD / American flag: in place, 8 bits from the top, the elements are cycled directly into their
+            buckets, then every bucket is sorted on the next 8 bits => no buffer, for memory-tight cases
+            - parallel LSD: in every pass each thread counts and scatters its own chunk, with its own offsets per bucket
+
+    Top-k / partial sort (the k smallest elements, sorted):
+            - streaming (TopKStream): a max heap of the k smallest elements seen so far; a new element smaller than
+            the root replaces it and heapifyBU restores the heap => O(n * log k) time, O(k) memory
+            - in memory (partialSort): nthElement puts the k smallest in front, introsort sorts only them
+            => O(n + k * log k)
+
+    External sort (externalSort, files bigger than the memory):
+            - the input is cut into chunks of half the memory budget, each is sorted with introsort and written
+            to a temp file (a run); the next chunk is read while the current one is sorted
+            - the runs are merged with a loser tree: a match per level on the path of the last winner only,
+            => log2 k comparisons per element, n * log2 k for the merge; with too many runs for the buffers
+            the merge takes several passes
+            - all the I/O is sequential, in buffers of at least EXT_MIN_BUFFER ints
 */
 
 
@@ -25,109 +83,167 @@
 
 #include <iostream>
 #include <time.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <string>
 
 #define MAXN 5001
 #define N 10
+#define INSERTION_CUTOFF 16
+#define NINTHER_THRESHOLD 128
+#define BENCH_RUNS 15
+#define BLOCK_SIZE 128
+#define PAR_SEQ_CUTOFF 65536
+#define PAR_PARTITION_MIN 4000000
+#define PARTIAL_INSERTION_LIMIT 8
+#define EXT_DEFAULT_MEM_MB 256
+#define EXT_MIN_BUFFER 65536
 
 int operationsHS = 0;
 int operationsQS = 0;
+int operationsRS = 0;
+
+//operation counting policies: CountOps adds to the global counters, NoOps compiles to nothing,
+//so the NoOps instantiation of a sort has no stores to the counters in its inner loops
+//build with -DNO_OP_COUNT to make NoOps the default everywhere (the csv counts are then 0)
+
+struct CountOps {
+	static void add(int& counter, int value) { counter = counter + value; }
+};
+
+struct NoOps {
+	static void add(int&, int) {}
+};
+
+#ifdef NO_OP_COUNT
+typedef NoOps DefaultOps;
+#else
+typedef CountOps DefaultOps;
+#endif
 
 //heapsort
 
+//Floyd's sift-down: the root element is lifted into a "hole" that is moved down along the larger children
+//to a leaf (1 comparison per level), then the element is sifted up from there and written only once
+//operations: 1 per comparison and 1 per assignment (a move of the hole instead of a 3-assignment swap)
+template <class Ops = DefaultOps>
 void heapifyBU(int arr[], int arrSize, int root) {
-	int largest = root;
-	int leftChildInd = 2 * root + 1;
-	int rightChildInd = 2 * root + 2;
-
-	operationsHS++;
-	if (leftChildInd < arrSize && arr[leftChildInd] > arr[largest]) {
-		largest = leftChildInd;
-	}
+	int buff = arr[root];
+	Ops::add(operationsHS, 1);
+	int hole = root;
+	int child = 2 * hole + 1;
 
-	operationsHS++;
-	if (rightChildInd < arrSize && arr[rightChildInd] > arr[largest]) {
-		largest = rightChildInd;
+	while (child < arrSize) {
+		if (child + 1 < arrSize) {
+			Ops::add(operationsHS, 1);
+			if (arr[child + 1] > arr[child]) {
+				child++;
+			}
+		}
+		arr[hole] = arr[child];
+		Ops::add(operationsHS, 1);
+		hole = child;
+		child = 2 * hole + 1;
 	}
 
-	if (largest != root) {
-		std::swap(arr[largest], arr[root]);
-		operationsHS = operationsHS + 3;
-		heapifyBU(arr, arrSize, largest);
+	while (hole > root) {
+		int parent = (hole - 1) / 2;
+		Ops::add(operationsHS, 1);
+		if (arr[parent] >= buff) {
+			break;
+		}
+		arr[hole] = arr[parent];
+		Ops::add(operationsHS, 1);
+		hole = parent;
 	}
+	arr[hole] = buff;
+	Ops::add(operationsHS, 1);
 }
 
+template <class Ops = DefaultOps>
 void buildHeapBU(int arr[], int arrSize) {
 	for (int i = (arrSize / 2) - 1; i >= 0; i--) {
-		heapifyBU(arr, arrSize, i);
+		heapifyBU<Ops>(arr, arrSize, i);
 	}
 }
 
+template <class Ops = DefaultOps>
 void heapSort(int arr[], int arrSize) {
-	buildHeapBU(arr, arrSize);
+	buildHeapBU<Ops>(arr, arrSize);
 
 	for (int i = arrSize - 1; i >= 1; i--) {
 		std::swap(arr[0], arr[i]);
-		operationsHS = operationsHS + 3;
+		Ops::add(operationsHS, 3);
 		arrSize--;
-		heapifyBU(arr, arrSize, 0);
+		heapifyBU<Ops>(arr, arrSize, 0);
 	}
 }
 
 //quicksort average
 
+template <class Ops = DefaultOps>
 int partition(int arr[], int left, int right) {
 	int pivot = arr[right];
-	operationsQS++;
+	Ops::add(operationsQS, 1);
 	int i = left - 1;
 
 	for (int j = left; j < right; j++) {
-		operationsQS++;
+		Ops::add(operationsQS, 1);
 		if (arr[j] <= pivot) {
 			i++;
 
 			std::swap(arr[i], arr[j]);
-			operationsQS = operationsQS + 3;
+			Ops::add(operationsQS, 3);
 		}
 	}
 	std::swap(arr[i + 1], arr[right]);
-	operationsQS = operationsQS + 3;
+	Ops::add(operationsQS, 3);
 	return i + 1;
 }
 
+template <class Ops = DefaultOps>
 void quickSort(int arr[], int left, int right) {
 	if (left < right) {
-		int partIndex = partition(arr, left, right);
-		quickSort(arr, left, partIndex - 1);
-		quickSort(arr, partIndex + 1, right);
+		int partIndex = partition<Ops>(arr, left, right);
+		quickSort<Ops>(arr, left, partIndex - 1);
+		quickSort<Ops>(arr, partIndex + 1, right);
 	}
 }
 
 //quicksort best
 
+template <class Ops = DefaultOps>
 int partitionBest(int arr[], int left, int right) {
 	int pivot = arr[(right + left) / 2];
-	operationsQS++;
+	Ops::add(operationsQS, 1);
 	int i = left - 1;
 
 	for (int j = left; j < right; j++) {
-		operationsQS++;
+		Ops::add(operationsQS, 1);
 		if (arr[j] <= pivot) {
 			i++;
 
 			std::swap(arr[i], arr[j]);
-			operationsQS = operationsQS + 3;
+			Ops::add(operationsQS, 3);
 		}
 	}
 	std::swap(arr[i + 1], arr[right]);
-	operationsQS = operationsQS + 3;
+	Ops::add(operationsQS, 3);
 	return i + 1;
 }
 
+template <class Ops = DefaultOps>
 void quickSortBest(int arr[], int left, int right) {
 	if (left < right) {
-		int partIndex = partitionBest(arr, left, right);
-		quickSortBest(arr, left, partIndex - 1);
-		quickSortBest(arr, partIndex + 1, right);
+		int partIndex = partitionBest<Ops>(arr, left, right);
+		quickSortBest<Ops>(arr, left, partIndex - 1);
+		quickSortBest<Ops>(arr, partIndex + 1, right);
 	}
 }
 
@@ -137,41 +253,1627 @@ int random(int left, int right) {
 	return left + rand() % (right - left);
 }
 
+template <class Ops = DefaultOps>
 int randomizedPartition(int arr[], int left, int right) {
 	int i = random(left, right);
 
 	std::swap(arr[i], arr[right]);
-	return partition(arr, left, right);
+	return partition<Ops>(arr, left, right);
 }
 
+template <class Ops = DefaultOps>
 int randomizedSelect(int arr[], int left, int right, int i) {
 	if (left == right) {
 		return arr[left];
 	}
 
-	int q = randomizedPartition(arr, left, right);
+	int q = randomizedPartition<Ops>(arr, left, right);
 	int k = q - left + 1;
 	if (i == k) {
 		return arr[q];
 	}
 	else if (i < k) {
-		return randomizedSelect(arr, left, q - 1, i);
+		return randomizedSelect<Ops>(arr, left, q - 1, i);
 	}
-	else return randomizedSelect(arr, q + 1, right, i - k);
+	else return randomizedSelect<Ops>(arr, q + 1, right, i - k);
 }
 
+template <class Ops = DefaultOps>
 void quickSelect(int arr[], int left, int right, int arrSize)
 {
 
     if (left < right)
     {
-        int q = randomizedSelect(arr, left, right, (arrSize - 1) / 2);
+        int q = randomizedSelect<Ops>(arr, left, right, (arrSize - 1) / 2);
 
-        quickSort(arr, left, (arrSize - 1) / 2);
-        quickSort(arr, (arrSize - 1) / 2 + 1, right);
+        quickSort<Ops>(arr, left, (arrSize - 1) / 2);
+        quickSort<Ops>(arr, (arrSize - 1) / 2 + 1, right);
     }
 }
 
+//introsort
+
+template <class Ops = DefaultOps>
+void insertionSort(int arr[], int left, int right) {
+	for (int i = left + 1; i <= right; i++) {
+		int buff = arr[i];
+		Ops::add(operationsQS, 1);
+		int j = i - 1;
+		while (j >= left && arr[j] > buff) {
+			Ops::add(operationsQS, 1);
+			arr[j + 1] = arr[j];
+			Ops::add(operationsQS, 1);
+			j--;
+		}
+		Ops::add(operationsQS, 1);
+		arr[j + 1] = buff;
+		Ops::add(operationsQS, 1);
+	}
+}
+
+//arr[a] <= arr[b] <= arr[c]
+template <class Ops = DefaultOps>
+void sort3(int arr[], int a, int b, int c) {
+	Ops::add(operationsQS, 1);
+	if (arr[b] < arr[a]) {
+		std::swap(arr[a], arr[b]);
+		Ops::add(operationsQS, 3);
+	}
+	Ops::add(operationsQS, 1);
+	if (arr[c] < arr[b]) {
+		std::swap(arr[b], arr[c]);
+		Ops::add(operationsQS, 3);
+		Ops::add(operationsQS, 1);
+		if (arr[b] < arr[a]) {
+			std::swap(arr[a], arr[b]);
+			Ops::add(operationsQS, 3);
+		}
+	}
+}
+
+//moves the median of three (or the ninther) to arr[right], where partition takes its pivot from
+template <class Ops = DefaultOps>
+void choosePivot(int arr[], int left, int right) {
+	int mid = left + (right - left) / 2;
+	if (right - left + 1 > NINTHER_THRESHOLD) {
+		int step = (right - left + 1) / 8;
+		sort3<Ops>(arr, left, left + step, left + 2 * step);
+		sort3<Ops>(arr, mid - step, mid, mid + step);
+		sort3<Ops>(arr, right - 2 * step, right - step, right);
+		sort3<Ops>(arr, left + step, mid, right - step);
+	}
+	else {
+		sort3<Ops>(arr, left, mid, right);
+	}
+	std::swap(arr[mid], arr[right]);
+	Ops::add(operationsQS, 3);
+}
+
+template <class Ops = DefaultOps>
+void introSortLoop(int arr[], int left, int right, int depthLimit) {
+	while (right - left + 1 > INSERTION_CUTOFF) {
+		if (depthLimit == 0) {
+			heapSort<Ops>(arr + left, right - left + 1);
+			return;
+		}
+		depthLimit--;
+
+		choosePivot<Ops>(arr, left, right);
+		int partIndex = partition<Ops>(arr, left, right);
+		if (partIndex - left < right - partIndex) {
+			introSortLoop<Ops>(arr, left, partIndex - 1, depthLimit);
+			left = partIndex + 1;
+		}
+		else {
+			introSortLoop<Ops>(arr, partIndex + 1, right, depthLimit);
+			right = partIndex - 1;
+		}
+	}
+	insertionSort<Ops>(arr, left, right);
+}
+
+template <class Ops = DefaultOps>
+void introSort(int arr[], int left, int right) {
+	int depthLimit = 0;
+	for (int n = right - left + 1; n > 1; n = n / 2) {
+		depthLimit = depthLimit + 2;
+	}
+	introSortLoop<Ops>(arr, left, right, depthLimit);
+}
+
+//partition modes
+
+enum PartitionMode {
+	PART_LOMUTO,
+	PART_HOARE,
+	PART_THREE_WAY,
+	PART_BLOCK,
+	NR_PARTITION_MODES
+};
+
+const char* partitionModeNames[NR_PARTITION_MODES] = { "lomuto", "hoare", "three-way", "block" };
+
+//pivot = arr[left]: [left, j] <= pivot, [j + 1, right] >= pivot, left <= j < right
+template <class Ops = DefaultOps>
+int partitionHoare(int arr[], int left, int right) {
+	int pivot = arr[left];
+	Ops::add(operationsQS, 1);
+	int i = left - 1;
+	int j = right + 1;
+	while (true) {
+		do {
+			i++;
+			Ops::add(operationsQS, 1);
+		} while (arr[i] < pivot);
+		do {
+			j--;
+			Ops::add(operationsQS, 1);
+		} while (arr[j] > pivot);
+		if (i >= j) {
+			return j;
+		}
+		std::swap(arr[i], arr[j]);
+		Ops::add(operationsQS, 3);
+	}
+}
+
+//pivot = arr[right]: [left, lt) < pivot, [lt, gt] == pivot, (gt, right] > pivot
+template <class Ops = DefaultOps>
+void partitionThreeWay(int arr[], int left, int right, int* lt, int* gt) {
+	int pivot = arr[right];
+	Ops::add(operationsQS, 1);
+	int lo = left;
+	int i = left;
+	int hi = right;
+	while (i <= hi) {
+		Ops::add(operationsQS, 1);
+		if (arr[i] < pivot) {
+			std::swap(arr[lo], arr[i]);
+			Ops::add(operationsQS, 3);
+			lo++;
+			i++;
+		}
+		else {
+			Ops::add(operationsQS, 1);
+			if (arr[i] > pivot) {
+				std::swap(arr[i], arr[hi]);
+				Ops::add(operationsQS, 3);
+				hi--;
+			}
+			else {
+				i++;
+			}
+		}
+	}
+	*lt = lo;
+	*gt = hi;
+}
+
+//pivot = arr[left], returns its final position: [left, m) <= pivot, (m, right] >= pivot
+//the left block records the offsets of the elements >= pivot, the right block those <= pivot, the comparison
+//result is added to the counter instead of branched on; then min(numL, numR) pairs are swapped
+template <class Ops = DefaultOps>
+int partitionBlock(int arr[], int left, int right) {
+	int pivot = arr[left];
+	Ops::add(operationsQS, 1);
+	int l = left + 1;
+	int r = right;
+	unsigned char offsetsL[BLOCK_SIZE];
+	unsigned char offsetsR[BLOCK_SIZE];
+	int numL = 0;
+	int numR = 0;
+	int startL = 0;
+	int startR = 0;
+
+	while (r - l + 1 > 2 * BLOCK_SIZE) {
+		if (numL == 0) {
+			startL = 0;
+			for (int i = 0; i < BLOCK_SIZE; i++) {
+				offsetsL[numL] = (unsigned char)i;
+				numL += (arr[l + i] >= pivot);
+			}
+			Ops::add(operationsQS, BLOCK_SIZE);
+		}
+		if (numR == 0) {
+			startR = 0;
+			for (int i = 0; i < BLOCK_SIZE; i++) {
+				offsetsR[numR] = (unsigned char)i;
+				numR += (arr[r - i] <= pivot);
+			}
+			Ops::add(operationsQS, BLOCK_SIZE);
+		}
+		int num = std::min(numL, numR);
+		for (int k = 0; k < num; k++) {
+			std::swap(arr[l + offsetsL[startL + k]], arr[r - offsetsR[startR + k]]);
+		}
+		Ops::add(operationsQS, 3 * num);
+		numL -= num;
+		numR -= num;
+		startL += num;
+		startR += num;
+		if (numL == 0) {
+			l += BLOCK_SIZE;
+		}
+		if (numR == 0) {
+			r -= BLOCK_SIZE;
+		}
+	}
+
+	//the rest (and a block that was not finished) with a plain scan from both ends
+	while (true) {
+		while (l <= r && arr[l] < pivot) {
+			Ops::add(operationsQS, 1);
+			l++;
+		}
+		while (l <= r && arr[r] > pivot) {
+			Ops::add(operationsQS, 1);
+			r--;
+		}
+		Ops::add(operationsQS, 2);
+		if (l >= r) {
+			break;
+		}
+		std::swap(arr[l], arr[r]);
+		Ops::add(operationsQS, 3);
+		l++;
+		r--;
+	}
+	std::swap(arr[left], arr[r]);
+	Ops::add(operationsQS, 3);
+	return r;
+}
+
+//quicksort with the chosen partition; smaller side recursive, insertion sort below INSERTION_CUTOFF
+template <class Ops = DefaultOps>
+void quickSortMode(int arr[], int left, int right, PartitionMode mode) {
+	while (right - left + 1 > INSERTION_CUTOFF) {
+		choosePivot<Ops>(arr, left, right);
+		int leftEnd;
+		int rightBegin;
+		if (mode == PART_LOMUTO) {
+			int partIndex = partition<Ops>(arr, left, right);
+			leftEnd = partIndex - 1;
+			rightBegin = partIndex + 1;
+		}
+		else if (mode == PART_THREE_WAY) {
+			int lt, gt;
+			partitionThreeWay<Ops>(arr, left, right, &lt, &gt);
+			leftEnd = lt - 1;
+			rightBegin = gt + 1;
+		}
+		else {
+			//Hoare and block partitions take the pivot from arr[left]
+			std::swap(arr[left], arr[right]);
+			Ops::add(operationsQS, 3);
+			if (mode == PART_HOARE) {
+				leftEnd = partitionHoare<Ops>(arr, left, right);
+				rightBegin = leftEnd + 1;
+			}
+			else {
+				int partIndex = partitionBlock<Ops>(arr, left, right);
+				leftEnd = partIndex - 1;
+				rightBegin = partIndex + 1;
+			}
+		}
+
+		if (leftEnd - left < right - rightBegin) {
+			quickSortMode<Ops>(arr, left, leftEnd, mode);
+			left = rightBegin;
+		}
+		else {
+			quickSortMode<Ops>(arr, rightBegin, right, mode);
+			right = leftEnd;
+		}
+	}
+	insertionSort<Ops>(arr, left, right);
+}
+
+//adaptive (pattern-defeating) sort
+
+//insertion sort that gives up after PARTIAL_INSERTION_LIMIT moved elements; true if [left, right] got sorted
+template <class Ops = DefaultOps>
+bool partialInsertionSort(int arr[], int left, int right) {
+	int moved = 0;
+	for (int i = left + 1; i <= right; i++) {
+		int buff = arr[i];
+		Ops::add(operationsQS, 1);
+		if (arr[i - 1] <= buff) {
+			continue;
+		}
+		int j = i - 1;
+		while (j >= left && arr[j] > buff) {
+			Ops::add(operationsQS, 1);
+			arr[j + 1] = arr[j];
+			Ops::add(operationsQS, 1);
+			j--;
+		}
+		arr[j + 1] = buff;
+		Ops::add(operationsQS, 1);
+		moved = moved + (i - j - 1);
+		if (moved > PARTIAL_INSERTION_LIMIT) {
+			return i == right;
+		}
+	}
+	return true;
+}
+
+//pivot = arr[right], returns its final position: [left, m) < pivot, (m, right] >= pivot
+//alreadyPartitioned = no element had to be swapped
+template <class Ops = DefaultOps>
+int partitionAdaptive(int arr[], int left, int right, bool* alreadyPartitioned) {
+	int pivot = arr[right];
+	Ops::add(operationsQS, 1);
+	int i = left;
+	int j = right - 1;
+	//arr[right] == pivot stops the first scan
+	while (arr[i] < pivot) {
+		Ops::add(operationsQS, 1);
+		i++;
+	}
+	while (j > i && arr[j] >= pivot) {
+		Ops::add(operationsQS, 1);
+		j--;
+	}
+	*alreadyPartitioned = i >= j;
+	//after a swap arr[j] >= pivot stops the scan of i and arr[i] < pivot the scan of j
+	while (i < j) {
+		std::swap(arr[i], arr[j]);
+		Ops::add(operationsQS, 3);
+		do {
+			Ops::add(operationsQS, 1);
+			i++;
+		} while (arr[i] < pivot);
+		do {
+			Ops::add(operationsQS, 1);
+			j--;
+		} while (arr[j] >= pivot);
+	}
+	std::swap(arr[i], arr[right]);
+	Ops::add(operationsQS, 3);
+	return i;
+}
+
+//swaps a few elements of a side that came out too small, so the next pivot is not picked from the same pattern
+template <class Ops = DefaultOps>
+void breakPatterns(int arr[], int left, int right) {
+	int size = right - left + 1;
+	if (size > INSERTION_CUTOFF) {
+		std::swap(arr[left], arr[left + size / 4]);
+		std::swap(arr[right], arr[right - size / 4]);
+		std::swap(arr[left + size / 2], arr[left + size / 2 - size / 8]);
+		Ops::add(operationsQS, 9);
+	}
+}
+
+//leftmost = no element on the left of the range; otherwise arr[left - 1] <= every element of [left, right]
+template <class Ops = DefaultOps>
+void adaptiveSortLoop(int arr[], int left, int right, int badAllowed, bool leftmost) {
+	while (right - left + 1 > INSERTION_CUTOFF) {
+		int size = right - left + 1;
+		choosePivot<Ops>(arr, left, right);
+
+		//the pivot equals the element before the range => no element is smaller, keep only the > pivot side
+		Ops::add(operationsQS, 1);
+		if (!leftmost && arr[left - 1] >= arr[right]) {
+			int lt, gt;
+			partitionThreeWay<Ops>(arr, left, right, &lt, &gt);
+			left = gt + 1;
+			continue;
+		}
+
+		bool alreadyPartitioned;
+		int partIndex = partitionAdaptive<Ops>(arr, left, right, &alreadyPartitioned);
+		int leftSize = partIndex - left;
+		int rightSize = right - partIndex;
+
+		if (leftSize < size / 8 || rightSize < size / 8) {
+			badAllowed--;
+			if (badAllowed == 0) {
+				heapSort<Ops>(arr + left, size);
+				return;
+			}
+			breakPatterns<Ops>(arr, left, partIndex - 1);
+			breakPatterns<Ops>(arr, partIndex + 1, right);
+		}
+		else if (alreadyPartitioned && partialInsertionSort<Ops>(arr, left, partIndex - 1) &&
+			partialInsertionSort<Ops>(arr, partIndex + 1, right)) {
+			return;
+		}
+
+		if (leftSize < rightSize) {
+			adaptiveSortLoop<Ops>(arr, left, partIndex - 1, badAllowed, leftmost);
+			left = partIndex + 1;
+			leftmost = false;
+		}
+		else {
+			adaptiveSortLoop<Ops>(arr, partIndex + 1, right, badAllowed, false);
+			right = partIndex - 1;
+		}
+	}
+	insertionSort<Ops>(arr, left, right);
+}
+
+template <class Ops = DefaultOps>
+void adaptiveSort(int arr[], int left, int right) {
+	int size = right - left + 1;
+	if (size < 2) {
+		return;
+	}
+
+	//runs: descending ones of at least INSERTION_CUTOFF elements are reversed in place; the scan stops once
+	//the runs are too short on average to be of use
+	int nrRuns = 0;
+	bool shortDescending = false;
+	int maxRuns = size / INSERTION_CUTOFF + 1;
+	int i = left;
+	while (i <= right && nrRuns <= maxRuns) {
+		int j = i + 1;
+		Ops::add(operationsQS, 1);
+		if (j <= right && arr[j] < arr[i]) {
+			while (j <= right && arr[j] < arr[j - 1]) {
+				Ops::add(operationsQS, 1);
+				j++;
+			}
+			if (j - i >= INSERTION_CUTOFF) {
+				std::reverse(arr + i, arr + j);
+				Ops::add(operationsQS, 3 * ((j - i) / 2));
+			}
+			else {
+				shortDescending = true;
+			}
+		}
+		else {
+			while (j <= right && arr[j] >= arr[j - 1]) {
+				Ops::add(operationsQS, 1);
+				j++;
+			}
+		}
+		nrRuns++;
+		i = j;
+	}
+	if (nrRuns == 1 && !shortDescending) {
+		return;
+	}
+
+	int badAllowed = 0;
+	for (int n = size; n > 1; n = n / 2) {
+		badAllowed++;
+	}
+	adaptiveSortLoop<Ops>(arr, left, right, badAllowed, true);
+}
+
+//selection
+
+template <class Ops = DefaultOps>
+void selectMedianOfMedians(int arr[], int left, int right, int k);
+
+//groups of 5 are sorted and their medians moved to the front, the median of those is selected
+//returns the position of the pivot
+template <class Ops = DefaultOps>
+int medianOfMedians(int arr[], int left, int right) {
+	if (right - left < 5) {
+		insertionSort<Ops>(arr, left, right);
+		return left + (right - left) / 2;
+	}
+	int store = left;
+	for (int i = left; i <= right; i = i + 5) {
+		int groupRight = std::min(i + 4, right);
+		insertionSort<Ops>(arr, i, groupRight);
+		std::swap(arr[i + (groupRight - i) / 2], arr[store]);
+		Ops::add(operationsQS, 3);
+		store++;
+	}
+	int mid = left + (store - 1 - left) / 2;
+	selectMedianOfMedians<Ops>(arr, left, store - 1, mid);
+	return mid;
+}
+
+//the median of medians (moved to arr[right]) as pivot for every partition
+template <class Ops>
+void selectMedianOfMedians(int arr[], int left, int right, int k) {
+	while (right - left + 1 > INSERTION_CUTOFF) {
+		int p = medianOfMedians<Ops>(arr, left, right);
+		std::swap(arr[p], arr[right]);
+		Ops::add(operationsQS, 3);
+		int lt, gt;
+		partitionThreeWay<Ops>(arr, left, right, &lt, &gt);
+		if (k < lt) {
+			right = lt - 1;
+		}
+		else if (k > gt) {
+			left = gt + 1;
+		}
+		else {
+			return;
+		}
+	}
+	insertionSort<Ops>(arr, left, right);
+}
+
+//partitions [left, right] around a median of three pivot, or around the median of medians when asked
+template <class Ops = DefaultOps>
+void selectPartition(int arr[], int left, int right, bool guaranteed, int* lt, int* gt) {
+	if (guaranteed) {
+		int p = medianOfMedians<Ops>(arr, left, right);
+		std::swap(arr[p], arr[right]);
+		Ops::add(operationsQS, 3);
+	}
+	else {
+		choosePivot<Ops>(arr, left, right);
+	}
+	partitionThreeWay<Ops>(arr, left, right, lt, gt);
+}
+
+//arr[k] = the element that would be at index k in sorted order, smaller ones before it, greater ones after it
+template <class Ops = DefaultOps>
+void nthElement(int arr[], int left, int right, int k) {
+	int badSplits = 0;
+	while (right - left + 1 > INSERTION_CUTOFF) {
+		int size = right - left + 1;
+		int lt, gt;
+		selectPartition<Ops>(arr, left, right, badSplits >= 2, &lt, &gt);
+		if (k < lt) {
+			right = lt - 1;
+		}
+		else if (k > gt) {
+			left = gt + 1;
+		}
+		else {
+			return;
+		}
+		if (4LL * (right - left + 1) > 3LL * size) {
+			badSplits++;
+		}
+		else {
+			badSplits = 0;
+		}
+	}
+	insertionSort<Ops>(arr, left, right);
+}
+
+template <class Ops = DefaultOps>
+void multiSelectRange(int arr[], int left, int right, const int ranks[], int nrRanks, int badSplits) {
+	while (nrRanks > 0) {
+		if (right - left + 1 <= INSERTION_CUTOFF) {
+			insertionSort<Ops>(arr, left, right);
+			return;
+		}
+		int size = right - left + 1;
+		int lt, gt;
+		selectPartition<Ops>(arr, left, right, badSplits >= 2, &lt, &gt);
+
+		//ranks[0 .. nrLeft) are in the left side, ranks[nrLeft .. nrRight) in the pivot block (done)
+		int nrLeft = 0;
+		while (nrLeft < nrRanks && ranks[nrLeft] < lt) {
+			nrLeft++;
+		}
+		int nrRight = nrLeft;
+		while (nrRight < nrRanks && ranks[nrRight] <= gt) {
+			nrRight++;
+		}
+
+		//recursion into the side with fewer elements, the loop goes on with the other one
+		if (lt - left < right - gt) {
+			multiSelectRange<Ops>(arr, left, lt - 1, ranks, nrLeft, 4LL * (lt - left) > 3LL * size ? badSplits + 1 : 0);
+			badSplits = 4LL * (right - gt) > 3LL * size ? badSplits + 1 : 0;
+			ranks = ranks + nrRight;
+			nrRanks = nrRanks - nrRight;
+			left = gt + 1;
+		}
+		else {
+			multiSelectRange<Ops>(arr, gt + 1, right, ranks + nrRight, nrRanks - nrRight,
+				4LL * (right - gt) > 3LL * size ? badSplits + 1 : 0);
+			badSplits = 4LL * (lt - left) > 3LL * size ? badSplits + 1 : 0;
+			nrRanks = nrLeft;
+			right = lt - 1;
+		}
+	}
+}
+
+//ranks: indexes in [left, right], in ascending order; afterwards every arr[ranks[i]] is as in the sorted array
+template <class Ops = DefaultOps>
+void multiSelect(int arr[], int left, int right, const int ranks[], int nrRanks) {
+	multiSelectRange<Ops>(arr, left, right, ranks, nrRanks, 0);
+}
+
+//top-k
+
+//keeps the k smallest elements of a stream of any length in a max heap of k elements
+template <class Ops = DefaultOps>
+class TopKStream {
+public:
+	explicit TopKStream(int k) : k(k < 0 ? 0 : k) {
+		heap.reserve(this->k);
+	}
+
+	void push(int x) {
+		if ((int)heap.size() < k) {
+			heap.push_back(x);
+			if ((int)heap.size() == k) {
+				buildHeapBU<Ops>(heap.data(), k);
+			}
+			return;
+		}
+		Ops::add(operationsHS, 1);
+		if (k > 0 && x < heap[0]) {
+			heap[0] = x;
+			Ops::add(operationsHS, 1);
+			heapifyBU<Ops>(heap.data(), k, 0);
+		}
+	}
+
+	int size() const {
+		return (int)heap.size();
+	}
+
+	//the min(k, pushed) smallest elements in ascending order, out must have room for size() elements
+	void result(int out[]) const {
+		for (int i = 0; i < (int)heap.size(); i++) {
+			out[i] = heap[i];
+		}
+		heapSort<Ops>(out, (int)heap.size());
+	}
+
+private:
+	int k;
+	std::vector<int> heap;
+};
+
+//arr[0 .. k) = the k smallest elements in ascending order, the rest of arr in no particular order
+template <class Ops = DefaultOps>
+void partialSort(int arr[], int arrSize, int k) {
+	if (k <= 0 || arrSize <= 0) {
+		return;
+	}
+	if (k < arrSize) {
+		nthElement<Ops>(arr, 0, arrSize - 1, k - 1);
+	}
+	else {
+		k = arrSize;
+	}
+	introSort<Ops>(arr, 0, k - 1);
+}
+
+//radix sort; operations = 1 per element read for the histograms + 1 per element move
+
+inline unsigned int radixKey(int x) {
+	return (unsigned int)x ^ 0x80000000u;
+}
+
+template <class Ops = DefaultOps, int Bits = 8>
+void radixSortLSD(int arr[], int arrSize) {
+	const int nrBuckets = 1 << Bits;
+	const int nrPasses = (32 + Bits - 1) / Bits;
+	const unsigned int mask = nrBuckets - 1;
+	if (arrSize < 2) {
+		return;
+	}
+
+	std::vector<int> counts(nrPasses * nrBuckets, 0);
+	for (int i = 0; i < arrSize; i++) {
+		unsigned int key = radixKey(arr[i]);
+		for (int p = 0; p < nrPasses; p++) {
+			counts[p * nrBuckets + ((key >> (p * Bits)) & mask)]++;
+		}
+	}
+	Ops::add(operationsRS, arrSize);
+
+	std::vector<int> buffer(arrSize);
+	int* from = arr;
+	int* to = buffer.data();
+	for (int p = 0; p < nrPasses; p++) {
+		int* count = &counts[p * nrBuckets];
+		if (count[(radixKey(from[0]) >> (p * Bits)) & mask] == arrSize) {
+			continue;
+		}
+		int offset = 0;
+		for (int b = 0; b < nrBuckets; b++) {
+			int c = count[b];
+			count[b] = offset;
+			offset = offset + c;
+		}
+		for (int i = 0; i < arrSize; i++) {
+			to[count[(radixKey(from[i]) >> (p * Bits)) & mask]++] = from[i];
+		}
+		Ops::add(operationsRS, arrSize);
+		std::swap(from, to);
+	}
+	if (from != arr) {
+		memcpy(arr, from, arrSize * sizeof(int));
+		Ops::add(operationsRS, arrSize);
+	}
+}
+
+template <class Ops = DefaultOps>
+void americanFlagSort(int arr[], int left, int right, int shift) {
+	if (right - left + 1 <= INSERTION_CUTOFF) {
+		insertionSort<Ops>(arr, left, right);
+		return;
+	}
+
+	int count[256] = { 0 };
+	for (int i = left; i <= right; i++) {
+		count[(radixKey(arr[i]) >> shift) & 0xFF]++;
+	}
+	Ops::add(operationsRS, right - left + 1);
+
+	//head[b] = next free place of bucket b, bucket b ends at tail[b]
+	int head[256];
+	int tail[256];
+	int offset = left;
+	for (int b = 0; b < 256; b++) {
+		head[b] = offset;
+		offset = offset + count[b];
+		tail[b] = offset;
+	}
+	for (int b = 0; b < 256; b++) {
+		while (head[b] < tail[b]) {
+			int value = arr[head[b]];
+			int digit = (radixKey(value) >> shift) & 0xFF;
+			while (digit != b) {
+				std::swap(value, arr[head[digit]++]);
+				Ops::add(operationsRS, 1);
+				digit = (radixKey(value) >> shift) & 0xFF;
+			}
+			arr[head[b]++] = value;
+			Ops::add(operationsRS, 1);
+		}
+	}
+
+	if (shift > 0) {
+		int begin = left;
+		for (int b = 0; b < 256; b++) {
+			if (tail[b] - begin > 1) {
+				americanFlagSort<Ops>(arr, begin, tail[b] - 1, shift - 8);
+			}
+			begin = tail[b];
+		}
+	}
+}
+
+template <class Ops = DefaultOps>
+void radixSortMSD(int arr[], int arrSize) {
+	americanFlagSort<Ops>(arr, 0, arrSize - 1, 24);
+}
+
+//8 bit LSD; every pass counts and scatters in parallel: thread t handles the same chunk in both steps
+//(the histograms have to be counted again in every pass, the chunks hold other elements after a scatter)
+void radixSortParallel(int arr[], int arrSize, int nrThreads) {
+	if (nrThreads < 1) {
+		nrThreads = 1;
+	}
+	if (arrSize < 2) {
+		return;
+	}
+	std::vector<int> counts((size_t)nrThreads * 256);
+	std::vector<int> buffer(arrSize);
+	int* from = arr;
+	int* to = buffer.data();
+
+	for (int p = 0; p < 4; p++) {
+		std::fill(counts.begin(), counts.end(), 0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < nrThreads; t++) {
+			threads.push_back(std::thread([=, &counts]() {
+				int begin = (int)((long long)arrSize * t / nrThreads);
+				int end = (int)((long long)arrSize * (t + 1) / nrThreads);
+				int* count = &counts[(size_t)t * 256];
+				for (int i = begin; i < end; i++) {
+					count[(radixKey(from[i]) >> (8 * p)) & 0xFF]++;
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+
+		//offset of (bucket b, thread t) = all smaller buckets + bucket b of the threads before t => stable
+		int offset = 0;
+		bool skip = false;
+		for (int b = 0; b < 256; b++) {
+			int bucketBegin = offset;
+			for (int t = 0; t < nrThreads; t++) {
+				int& c = counts[(size_t)t * 256 + b];
+				int next = offset + c;
+				c = offset;
+				offset = next;
+			}
+			if (offset - bucketBegin == arrSize) {
+				skip = true;
+			}
+		}
+		if (skip) {
+			continue;
+		}
+
+		threads.clear();
+		for (int t = 0; t < nrThreads; t++) {
+			threads.push_back(std::thread([=, &counts]() {
+				int begin = (int)((long long)arrSize * t / nrThreads);
+				int end = (int)((long long)arrSize * (t + 1) / nrThreads);
+				int* count = &counts[(size_t)t * 256];
+				for (int i = begin; i < end; i++) {
+					to[count[(radixKey(from[i]) >> (8 * p)) & 0xFF]++] = from[i];
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+		std::swap(from, to);
+	}
+	if (from != arr) {
+		memcpy(arr, from, arrSize * sizeof(int));
+	}
+}
+
+//parallel quicksort; sorts without counting, the counters are not shared safely between threads
+
+class ParallelQuickSort {
+public:
+	ParallelQuickSort(int arr[], int nrThreads) : arr(arr), nrThreads(nrThreads < 1 ? 1 : nrThreads),
+		queues(nrThreads < 1 ? 1 : nrThreads), pending(0) {
+	}
+
+	void sort(int left, int right) {
+		if (right - left + 1 > PAR_PARTITION_MIN && nrThreads > 1) {
+			tmp.resize(right - left + 1);
+		}
+		int next = 0;
+		partitionTop(left, right, 0, &next);
+		std::vector<int>().swap(tmp);
+
+		std::vector<std::thread> threads;
+		for (int id = 1; id < nrThreads; id++) {
+			threads.push_back(std::thread(&ParallelQuickSort::worker, this, id));
+		}
+		worker(0);
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+
+private:
+	struct Task {
+		int left;
+		int right;
+	};
+
+	struct WorkerQueue {
+		std::mutex m;
+		std::deque<Task> tasks;
+	};
+
+	//parallel three-way partitions while the ranges are big, the rest becomes the first tasks (round robin)
+	void partitionTop(int left, int right, int depth, int* next) {
+		if (left >= right) {
+			return;
+		}
+		if (right - left + 1 <= PAR_PARTITION_MIN || nrThreads == 1 || (1 << depth) >= 2 * nrThreads) {
+			pushTask(*next, Task{ left, right });
+			*next = (*next + 1) % nrThreads;
+			return;
+		}
+		int lt, gt;
+		parallelPartition(left, right, &lt, &gt);
+		partitionTop(left, lt - 1, depth + 1, next);
+		partitionTop(gt + 1, right, depth + 1, next);
+	}
+
+	void parallelPartition(int left, int right, int* lt, int* gt) {
+		choosePivot<NoOps>(arr, left, right);
+		int pivot = arr[right];
+		long long n = right - left + 1;
+		std::vector<int> less(nrThreads + 1, 0);
+		std::vector<int> equal(nrThreads + 1, 0);
+		std::vector<int> greater(nrThreads + 1, 0);
+		int* a = arr;
+		int* buff = tmp.data();
+		int threadCount = nrThreads;
+
+		runOnAllThreads([=, &less, &equal, &greater](int t) {
+			int begin = left + (int)(n * t / threadCount);
+			int end = left + (int)(n * (t + 1) / threadCount);
+			int nrLess = 0;
+			int nrEqual = 0;
+			for (int i = begin; i < end; i++) {
+				nrLess += (a[i] < pivot);
+				nrEqual += (a[i] == pivot);
+			}
+			less[t + 1] = nrLess;
+			equal[t + 1] = nrEqual;
+			greater[t + 1] = (end - begin) - nrLess - nrEqual;
+		});
+
+		//exclusive prefix sums; the equal block starts after all the smaller ones, the greater after all the equal ones
+		for (int t = 0; t < nrThreads; t++) {
+			less[t + 1] += less[t];
+			equal[t + 1] += equal[t];
+			greater[t + 1] += greater[t];
+		}
+		int totalLess = less[nrThreads];
+		int totalEqual = equal[nrThreads];
+
+		runOnAllThreads([=, &less, &equal, &greater](int t) {
+			int begin = left + (int)(n * t / threadCount);
+			int end = left + (int)(n * (t + 1) / threadCount);
+			int posLess = less[t];
+			int posEqual = totalLess + equal[t];
+			int posGreater = totalLess + totalEqual + greater[t];
+			for (int i = begin; i < end; i++) {
+				if (a[i] < pivot) {
+					buff[posLess++] = a[i];
+				}
+				else if (a[i] == pivot) {
+					buff[posEqual++] = a[i];
+				}
+				else {
+					buff[posGreater++] = a[i];
+				}
+			}
+		});
+		runOnAllThreads([=](int t) {
+			long long begin = n * t / threadCount;
+			long long end = n * (t + 1) / threadCount;
+			memcpy(a + left + begin, buff + begin, (size_t)(end - begin) * sizeof(int));
+		});
+
+		*lt = left + totalLess;
+		*gt = left + totalLess + totalEqual - 1;
+	}
+
+	template <class Body>
+	void runOnAllThreads(Body body) {
+		std::vector<std::thread> threads;
+		for (int t = 1; t < nrThreads; t++) {
+			threads.push_back(std::thread(body, t));
+		}
+		body(0);
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+
+	void pushTask(int id, Task task) {
+		pending++;
+		std::lock_guard<std::mutex> lock(queues[id].m);
+		queues[id].tasks.push_back(task);
+	}
+
+	//own deque from the back (the most recent, cache-warm range), other deques from the front (the largest ranges)
+	bool popTask(int id, Task* task) {
+		{
+			std::lock_guard<std::mutex> lock(queues[id].m);
+			if (!queues[id].tasks.empty()) {
+				*task = queues[id].tasks.back();
+				queues[id].tasks.pop_back();
+				return true;
+			}
+		}
+		for (int k = 1; k < nrThreads; k++) {
+			WorkerQueue& victim = queues[(id + k) % nrThreads];
+			std::lock_guard<std::mutex> lock(victim.m);
+			if (!victim.tasks.empty()) {
+				*task = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void runTask(int id, Task task) {
+		int left = task.left;
+		int right = task.right;
+		while (right - left + 1 > PAR_SEQ_CUTOFF) {
+			choosePivot<NoOps>(arr, left, right);
+			std::swap(arr[left], arr[right]);
+			int j = partitionHoare<NoOps>(arr, left, right);
+			pushTask(id, Task{ j + 1, right });
+			right = j;
+		}
+		introSort<NoOps>(arr, left, right);
+	}
+
+	//a task is finished only after the tasks it pushed are counted, so pending == 0 means everything is sorted
+	void worker(int id) {
+		Task task;
+		while (pending.load() > 0) {
+			if (popTask(id, &task)) {
+				runTask(id, task);
+				pending--;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	int* arr;
+	int nrThreads;
+	std::vector<WorkerQueue> queues;
+	std::vector<int> tmp;
+	std::atomic<long long> pending;
+};
+
+void parallelQuickSort(int arr[], int left, int right, int nrThreads) {
+	ParallelQuickSort sorter(arr, nrThreads);
+	sorter.sort(left, right);
+}
+
+//external sort: binary files of native ints, larger than the memory budget
+
+//sequential reader of a run (or of the input) through a buffer of bufSize ints
+struct RunReader {
+	FILE* file;
+	std::vector<int> buf;
+	size_t pos;
+	size_t len;
+	bool done;
+	//a read error ends the run like EOF, the merge checks this afterwards
+	bool failed;
+
+	bool open(const char* path, size_t bufSize) {
+		file = fopen(path, "rb");
+		buf.resize(bufSize);
+		pos = 0;
+		len = 0;
+		done = (file == NULL);
+		failed = false;
+		if (file != NULL) {
+			refill();
+		}
+		return file != NULL;
+	}
+
+	void refill() {
+		len = fread(buf.data(), sizeof(int), buf.size(), file);
+		pos = 0;
+		if (len < buf.size() && ferror(file)) {
+			failed = true;
+			len = 0;
+		}
+		if (len == 0) {
+			done = true;
+		}
+	}
+
+	int key() const {
+		return buf[pos];
+	}
+
+	void next() {
+		pos++;
+		if (pos == len) {
+			refill();
+		}
+	}
+
+	void close() {
+		if (file != NULL) {
+			fclose(file);
+			file = NULL;
+		}
+	}
+};
+
+//tournament tree of losers over k runs: tree[0] = the run with the smallest key, every inner node keeps the run
+//that lost the match there, so after the winner advances only its path to the root is replayed (log2 k comparisons)
+class LoserTree {
+public:
+	explicit LoserTree(std::vector<RunReader>& runs) : runs(runs), k((int)runs.size()), tree(runs.size() > 0 ? runs.size() : 1) {
+		tree[0] = build(1);
+	}
+
+	bool empty() const {
+		return k == 0 || runs[tree[0]].done;
+	}
+
+	int top() const {
+		return runs[tree[0]].key();
+	}
+
+	void pop() {
+		int winner = tree[0];
+		runs[winner].next();
+		for (int node = (winner + k) / 2; node > 0; node = node / 2) {
+			if (beats(tree[node], winner)) {
+				std::swap(tree[node], winner);
+			}
+		}
+		tree[0] = winner;
+	}
+
+private:
+	//an exhausted run loses against everything, ties go to the lower run index (stable between runs)
+	bool beats(int a, int b) const {
+		if (runs[a].done || runs[b].done) {
+			return !runs[a].done;
+		}
+		return runs[a].key() < runs[b].key() || (runs[a].key() == runs[b].key() && a < b);
+	}
+
+	//the leaves are nodes k .. 2k - 1 (run = node - k); returns the winner of the subtree
+	int build(int node) {
+		if (node >= k) {
+			return node - k;
+		}
+		int left = build(2 * node);
+		int right = build(2 * node + 1);
+		if (beats(left, right)) {
+			tree[node] = right;
+			return left;
+		}
+		tree[node] = left;
+		return right;
+	}
+
+	std::vector<RunReader>& runs;
+	int k;
+	std::vector<int> tree;
+};
+
+static std::string runPath(const char* outPath, int pass, int index) {
+	char suffix[64];
+	snprintf(suffix, sizeof(suffix), ".run%d_%d", pass, index);
+	return std::string(outPath) + suffix;
+}
+
+static bool writeInts(FILE* file, const int arr[], size_t count) {
+	return fwrite(arr, sizeof(int), count, file) == count;
+}
+
+static void removeRuns(const std::vector<std::string>& paths) {
+	for (size_t i = 0; i < paths.size(); i++) {
+		remove(paths[i].c_str());
+	}
+}
+
+//merges the runs in paths into outPath; every run gets an equal share of memInts for its buffer, as does the output
+//the runs are removed afterwards, and so is outPath if the merge failed
+static bool mergeRuns(const std::vector<std::string>& paths, const char* outPath, size_t memInts) {
+	size_t bufSize = memInts / (paths.size() + 1);
+	std::vector<RunReader> runs(paths.size());
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (!runs[i].open(paths[i].c_str(), bufSize)) {
+			printf("external sort: can't open run %s\n", paths[i].c_str());
+			for (size_t j = 0; j < i; j++) {
+				runs[j].close();
+			}
+			removeRuns(paths);
+			return false;
+		}
+	}
+	FILE* fout = fopen(outPath, "wb");
+	if (fout == NULL) {
+		printf("external sort: can't create %s\n", outPath);
+		for (size_t i = 0; i < runs.size(); i++) {
+			runs[i].close();
+		}
+		removeRuns(paths);
+		return false;
+	}
+
+	std::vector<int> outBuf(bufSize);
+	size_t outLen = 0;
+	bool ok = true;
+	LoserTree tree(runs);
+	while (!tree.empty() && ok) {
+		outBuf[outLen++] = tree.top();
+		tree.pop();
+		if (outLen == outBuf.size()) {
+			ok = writeInts(fout, outBuf.data(), outLen);
+			outLen = 0;
+		}
+	}
+	if (ok) {
+		ok = writeInts(fout, outBuf.data(), outLen);
+	}
+	if (fclose(fout) != 0) {
+		ok = false;
+	}
+	if (!ok) {
+		printf("external sort: write to %s failed\n", outPath);
+	}
+	for (size_t i = 0; i < runs.size(); i++) {
+		if (runs[i].failed) {
+			printf("external sort: read from run %s failed\n", paths[i].c_str());
+			ok = false;
+		}
+		runs[i].close();
+	}
+	removeRuns(paths);
+	if (!ok) {
+		remove(outPath);
+	}
+	return ok;
+}
+
+//sorts the ints of inPath into outPath using about memBytes of memory:
+//	- runs: the input is read in chunks of memBytes / 2, the next chunk is read by a second thread while the
+//	current one is sorted with introsort and written to a temp file next to outPath
+//	- merge: up to fanIn runs at once with a loser tree, each run with a buffer of at least EXT_MIN_BUFFER ints;
+//	more runs than that are merged in several passes
+bool externalSort(const char* inPath, const char* outPath, size_t memBytes) {
+	size_t memInts = memBytes / sizeof(int);
+	if (memInts < 4 * EXT_MIN_BUFFER) {
+		memInts = 4 * EXT_MIN_BUFFER;
+	}
+	//introsort takes int indexes
+	size_t chunkSize = std::min(memInts / 2, (size_t)1 << 30);
+
+	FILE* fin = fopen(inPath, "rb");
+	if (fin == NULL) {
+		printf("external sort: can't open %s\n", inPath);
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<int> current(chunkSize);
+	std::vector<int> next(chunkSize);
+	std::vector<std::string> paths;
+	size_t total = 0;
+	size_t len = fread(current.data(), sizeof(int), chunkSize, fin);
+	bool readOk = !ferror(fin);
+	bool ok = true;
+	while (len > 0 && ok && readOk) {
+		size_t nextLen = 0;
+		std::thread reader([&]() {
+			nextLen = fread(next.data(), sizeof(int), chunkSize, fin);
+		});
+		introSort<NoOps>(current.data(), 0, (int)len - 1);
+		std::string path = runPath(outPath, 0, (int)paths.size());
+		FILE* frun = fopen(path.c_str(), "wb");
+		ok = frun != NULL && writeInts(frun, current.data(), len);
+		if (frun != NULL) {
+			if (fclose(frun) != 0) {
+				ok = false;
+			}
+			paths.push_back(path);
+		}
+		reader.join();
+		readOk = !ferror(fin);
+		total = total + len;
+		current.swap(next);
+		len = nextLen;
+	}
+	fclose(fin);
+	std::vector<int>().swap(current);
+	std::vector<int>().swap(next);
+	if (!ok || !readOk) {
+		if (!readOk) {
+			printf("external sort: read from %s failed\n", inPath);
+		} else {
+			printf("external sort: can't write run %d\n", (int)paths.size());
+		}
+		removeRuns(paths);
+		return false;
+	}
+	std::chrono::steady_clock::time_point runsDone = std::chrono::steady_clock::now();
+
+	if (paths.empty()) {
+		FILE* fout = fopen(outPath, "wb");
+		return fout != NULL && fclose(fout) == 0;
+	}
+
+	size_t fanIn = memInts / EXT_MIN_BUFFER - 1;
+	int pass = 1;
+	while (paths.size() > fanIn && ok) {
+		std::vector<std::string> merged;
+		size_t first = 0;
+		while (first < paths.size() && ok) {
+			size_t last = std::min(first + fanIn, paths.size());
+			std::vector<std::string> group(paths.begin() + first, paths.begin() + last);
+			merged.push_back(runPath(outPath, pass, (int)merged.size()));
+			ok = mergeRuns(group, merged.back().c_str(), memInts);
+			first = last;
+		}
+		if (!ok) {
+			//mergeRuns already removed its group and its output; drop the runs of this pass and the unmerged ones
+			removeRuns(merged);
+			removeRuns(std::vector<std::string>(paths.begin() + first, paths.end()));
+		}
+		paths.swap(merged);
+		pass++;
+	}
+	size_t nrRuns = paths.size();
+	ok = ok && mergeRuns(paths, outPath, memInts);
+	if (!ok) {
+		return false;
+	}
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+	double mb = (double)total * sizeof(int) / (1024.0 * 1024.0);
+	double runSec = std::chrono::duration<double>(runsDone - start).count();
+	double mergeSec = std::chrono::duration<double>(stop - runsDone).count();
+	printf("external sort: %.1f MB, %d merge pass(es), last one over %d runs\n", mb, pass, (int)nrRuns);
+	printf("  runs:  %.3f s, %.1f MB/s\n", runSec, mb / runSec);
+	printf("  merge: %.3f s, %.1f MB/s\n", mergeSec, mb / mergeSec);
+	printf("  total: %.3f s, %.1f MB/s\n", runSec + mergeSec, mb / (runSec + mergeSec));
+	return true;
+}
+
+//count random ints into path, written in blocks
+bool generateIntFile(const char* path, long long count) {
+	FILE* fout = fopen(path, "wb");
+	if (fout == NULL) {
+		printf("can't create %s\n", path);
+		return false;
+	}
+	std::vector<int> block(EXT_MIN_BUFFER);
+	bool ok = true;
+	while (count > 0 && ok) {
+		size_t len = (size_t)std::min<long long>(count, (long long)block.size());
+		for (size_t i = 0; i < len; i++) {
+			block[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand() ^ ((unsigned int)rand() << 30));
+		}
+		ok = writeInts(fout, block.data(), len);
+		count = count - (long long)len;
+	}
+	fclose(fout);
+	return ok;
+}
+
+//benchmark: operations of one counted run and the median time of BENCH_RUNS NoOps runs, for every sort
+//on the average (random), sorted and reverse inputs of the lab3.csv driver
+
+typedef void (*SortFunc)(int arr[], int arrSize);
+
+template <class Ops>
+void runHeapSort(int arr[], int arrSize) {
+	heapSort<Ops>(arr, arrSize);
+}
+
+template <class Ops>
+void runQuickSort(int arr[], int arrSize) {
+	quickSort<Ops>(arr, 0, arrSize - 1);
+}
+
+template <class Ops>
+void runIntroSort(int arr[], int arrSize) {
+	introSort<Ops>(arr, 0, arrSize - 1);
+}
+
+template <class Ops>
+void runAdaptiveSort(int arr[], int arrSize) {
+	adaptiveSort<Ops>(arr, 0, arrSize - 1);
+}
+
+template <class Ops, PartitionMode Mode>
+void runQuickSortMode(int arr[], int arrSize) {
+	quickSortMode<Ops>(arr, 0, arrSize - 1, Mode);
+}
+
+void benchSort(FILE* fout, const char* caseName, const char* sortName, SortFunc countedSort, SortFunc timedSort,
+	const std::vector<int>& src) {
+	int arrSize = (int)src.size();
+	std::vector<int> work(src);
+	operationsHS = 0;
+	operationsQS = 0;
+	operationsRS = 0;
+	countedSort(work.data(), arrSize);
+	int operations = operationsHS + operationsQS + operationsRS;
+	if (!std::is_sorted(work.begin(), work.end())) {
+		printf("%s did not sort the %s input\n", sortName, caseName);
+	}
+
+	std::vector<long long> ns(BENCH_RUNS);
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		work = src;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		timedSort(work.data(), arrSize);
+		std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+		ns[r] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+	}
+	std::sort(ns.begin(), ns.end());
+	fprintf(fout, "%d,%s,%s,%d,%lld\n", arrSize, caseName, sortName, operations, ns[BENCH_RUNS / 2]);
+}
+
+void benchSorts(FILE* fout, const char* caseName, const std::vector<int>& src) {
+	benchSort(fout, caseName, "heapsort", runHeapSort<CountOps>, runHeapSort<NoOps>, src);
+	benchSort(fout, caseName, "quicksort", runQuickSort<CountOps>, runQuickSort<NoOps>, src);
+	benchSort(fout, caseName, "introsort", runIntroSort<CountOps>, runIntroSort<NoOps>, src);
+	benchSort(fout, caseName, "adaptive", runAdaptiveSort<CountOps>, runAdaptiveSort<NoOps>, src);
+	benchSort(fout, caseName, "quicksort lomuto", runQuickSortMode<CountOps, PART_LOMUTO>,
+		runQuickSortMode<NoOps, PART_LOMUTO>, src);
+	benchSort(fout, caseName, "quicksort hoare", runQuickSortMode<CountOps, PART_HOARE>,
+		runQuickSortMode<NoOps, PART_HOARE>, src);
+	benchSort(fout, caseName, "quicksort three-way", runQuickSortMode<CountOps, PART_THREE_WAY>,
+		runQuickSortMode<NoOps, PART_THREE_WAY>, src);
+	benchSort(fout, caseName, "quicksort block", runQuickSortMode<CountOps, PART_BLOCK>,
+		runQuickSortMode<NoOps, PART_BLOCK>, src);
+	benchSort(fout, caseName, "radix lsd 8", radixSortLSD<CountOps, 8>, radixSortLSD<NoOps, 8>, src);
+	benchSort(fout, caseName, "radix lsd 11", radixSortLSD<CountOps, 11>, radixSortLSD<NoOps, 11>, src);
+	benchSort(fout, caseName, "radix msd", radixSortMSD<CountOps>, radixSortMSD<NoOps>, src);
+}
+
+void runBenchmarks() {
+	FILE* fout;
+	fout = fopen("lab3_bench.csv", "w+");
+	fprintf(fout, "N,Case,Sort,Operations,Median ns\n");
+
+	srand((unsigned int)time(NULL));
+	for (int arrSize = 500; arrSize <= 5000; arrSize = arrSize + 500) {
+		std::vector<int> src(arrSize);
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = rand() % MAXN;
+		}
+		benchSorts(fout, "average", src);
+
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = i;
+		}
+		benchSorts(fout, "sorted", src);
+
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = arrSize - 1 - i;
+		}
+		benchSorts(fout, "reverse", src);
+
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = rand() % 10;
+		}
+		benchSorts(fout, "few-unique", src);
+
+		//sorted, then 1% of the elements swapped with random positions
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = i;
+		}
+		for (int i = 0; i < arrSize / 100; i++) {
+			std::swap(src[rand() % arrSize], src[rand() % arrSize]);
+		}
+		benchSorts(fout, "nearly-sorted", src);
+	}
+	fclose(fout);
+}
+
+void runParallelQuickSort(int arr[], int arrSize, int nrThreads) {
+	parallelQuickSort(arr, 0, arrSize - 1, nrThreads);
+}
+
+//lab3_parallel.csv: the parallel sorts at 1, 2, 4, ... maxThreads threads on arrSize random ints
+void runParallelBenchmark(int arrSize, int maxThreads) {
+	FILE* fout;
+	fout = fopen("lab3_parallel.csv", "w+");
+	fprintf(fout, "N,Sort,Threads,Median ms,Speedup\n");
+
+	const char* sortNames[] = { "quicksort", "radix lsd 8" };
+	void (*sorts[])(int[], int, int) = { runParallelQuickSort, radixSortParallel };
+
+	std::vector<int> src(arrSize);
+	srand((unsigned int)time(NULL));
+	for (int i = 0; i < arrSize; i++) {
+		src[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand());
+	}
+	std::vector<int> work(arrSize);
+
+	for (int s = 0; s < 2; s++) {
+		double base = 0;
+		for (int threads = 1; threads <= maxThreads; threads = threads * 2) {
+			double ms[3];
+			for (int r = 0; r < 3; r++) {
+				work = src;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				sorts[s](work.data(), arrSize, threads);
+				std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+				ms[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+			}
+			if (!std::is_sorted(work.begin(), work.end())) {
+				printf("parallel %s with %d threads did not sort the array\n", sortNames[s], threads);
+			}
+			std::sort(ms, ms + 3);
+			if (threads == 1) {
+				base = ms[1];
+			}
+			fprintf(fout, "%d,%s,%d,%.3f,%.2f\n", arrSize, sortNames[s], threads, ms[1], base / ms[1]);
+			printf("N = %d, %s, %d threads: %.3f ms (speedup %.2f)\n", arrSize, sortNames[s], threads, ms[1],
+				base / ms[1]);
+		}
+	}
+	fclose(fout);
+}
+
+//lab3_select.csv: the time to find p50/p90/p99 of arrSize samples by sorting, by 3 * nthElement and by multiSelect
+void runSelectBenchmark() {
+	FILE* fout;
+	fout = fopen("lab3_select.csv", "w+");
+	fprintf(fout, "N,Case,Method,Median ms\n");
+
+	const char* caseNames[] = { "random", "sorted", "few-unique" };
+	const char* methodNames[] = { "introsort", "nthElement x3", "multiSelect" };
+	for (int arrSize = 100000; arrSize <= 10000000; arrSize = arrSize * 10) {
+		int ranks[] = { arrSize / 2, (int)(arrSize * 0.9), (int)(arrSize * 0.99) };
+		std::vector<int> src(arrSize);
+		std::vector<int> work(arrSize);
+		for (int c = 0; c < 3; c++) {
+			for (int i = 0; i < arrSize; i++) {
+				src[i] = c == 0 ? (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand()) : (c == 1 ? i : rand() % 10);
+			}
+			std::vector<int> expected(src);
+			std::sort(expected.begin(), expected.end());
+
+			for (int m = 0; m < 3; m++) {
+				double ms[3];
+				for (int r = 0; r < 3; r++) {
+					work = src;
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					if (m == 0) {
+						introSort<NoOps>(work.data(), 0, arrSize - 1);
+					}
+					else if (m == 1) {
+						//every select keeps the ranks found before it in place by starting right after them
+						for (int k = 0; k < 3; k++) {
+							nthElement<NoOps>(work.data(), k == 0 ? 0 : ranks[k - 1] + 1, arrSize - 1, ranks[k]);
+						}
+					}
+					else {
+						multiSelect<NoOps>(work.data(), 0, arrSize - 1, ranks, 3);
+					}
+					std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+					ms[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+				}
+				for (int k = 0; k < 3; k++) {
+					if (work[ranks[k]] != expected[ranks[k]]) {
+						printf("%s found a wrong order statistic\n", methodNames[m]);
+					}
+				}
+				std::sort(ms, ms + 3);
+				fprintf(fout, "%d,%s,%s,%.3f\n", arrSize, caseNames[c], methodNames[m], ms[1]);
+			}
+		}
+	}
+	fclose(fout);
+}
+
+//lab3_topk.csv: the k smallest of arrSize random ints by TopKStream, partialSort and a full introsort
+void runTopKBenchmark() {
+	FILE* fout;
+	fout = fopen("lab3_topk.csv", "w+");
+	fprintf(fout, "N,K,Method,Median ms\n");
+
+	const char* methodNames[] = { "stream heap", "partialSort", "introsort" };
+	for (int arrSize = 1000000; arrSize <= 10000000; arrSize = arrSize * 10) {
+		std::vector<int> src(arrSize);
+		for (int i = 0; i < arrSize; i++) {
+			src[i] = (int)(((unsigned int)rand() << 15) ^ (unsigned int)rand());
+		}
+		std::vector<int> expected(src);
+		std::sort(expected.begin(), expected.end());
+		std::vector<int> work(arrSize);
+
+		for (int k = 10; k <= 10000; k = k * 10) {
+			for (int m = 0; m < 3; m++) {
+				double ms[3];
+				for (int r = 0; r < 3; r++) {
+					work = src;
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					if (m == 0) {
+						TopKStream<NoOps> topK(k);
+						for (int i = 0; i < arrSize; i++) {
+							topK.push(src[i]);
+						}
+						topK.result(work.data());
+					}
+					else if (m == 1) {
+						partialSort<NoOps>(work.data(), arrSize, k);
+					}
+					else {
+						introSort<NoOps>(work.data(), 0, arrSize - 1);
+					}
+					std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+					ms[r] = std::chrono::duration<double, std::milli>(stop - start).count();
+				}
+				if (!std::equal(work.begin(), work.begin() + k, expected.begin())) {
+					printf("%s found wrong top-%d elements\n", methodNames[m], k);
+				}
+				std::sort(ms, ms + 3);
+				fprintf(fout, "%d,%d,%s,%.3f\n", arrSize, k, methodNames[m], ms[1]);
+			}
+		}
+	}
+	fclose(fout);
+}
+
 void showArr(int arr[], int arrSize) {
 	for (int i = 0; i < arrSize; i++) {
 		printf("%d ", arr[i]);
@@ -179,7 +1881,38 @@ void showArr(int arr[], int arrSize) {
 	printf("\n");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+	//timing mode, writes lab3_bench.csv instead of the operation-count charts
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		runBenchmarks();
+		return 0;
+	}
+	//lab03 --parallel [N] [maxThreads]: speedup of the parallel quicksort and radix sort (default 10^7 elements, up to 32 threads)
+	if (argc > 1 && strcmp(argv[1], "--parallel") == 0) {
+		runParallelBenchmark(argc > 2 ? atoi(argv[2]) : 10000000, argc > 3 ? atoi(argv[3]) : 32);
+		return 0;
+	}
+	//lab03 --select: percentiles (p50/p90/p99) by sorting vs nthElement vs multiSelect
+	if (argc > 1 && strcmp(argv[1], "--select") == 0) {
+		runSelectBenchmark();
+		return 0;
+	}
+	//lab03 --topk: the k smallest elements by a streaming heap vs partial sort vs full sort
+	if (argc > 1 && strcmp(argv[1], "--topk") == 0) {
+		runTopKBenchmark();
+		return 0;
+	}
+
+	//lab03 --extsort in out [memMB]: sorts a binary file of ints with at most memMB of buffers (default 256)
+	if (argc > 3 && strcmp(argv[1], "--extsort") == 0) {
+		size_t memMB = argc > 4 ? (size_t)atoi(argv[4]) : EXT_DEFAULT_MEM_MB;
+		return externalSort(argv[2], argv[3], memMB * 1024 * 1024) ? 0 : 1;
+	}
+	//lab03 --gen file count: a binary file of count random ints, input for --extsort
+	if (argc > 3 && strcmp(argv[1], "--gen") == 0) {
+		return generateIntFile(argv[2], atoll(argv[3])) ? 0 : 1;
+	}
+
 	FILE* fout;
 	fout = fopen("lab3.csv", "w+");
 	fprintf(fout, "N,Heapsort Operations,Quicksort Operations,Quicksort Operations,Quicksort Operations\n");
@@ -242,6 +1975,42 @@ int main() {
 	quickSort(arrQS, 0, N - 1);
 	showArr(arrQS, N);
 
+	printf("Proof of corectness introsort:\n");
+	for (int i = 0; i < N; i++) {
+		arrQS[i] = rand() % 100;
+	}
+	showArr(arrQS, N);
+	introSort(arrQS, 0, N - 1);
+	showArr(arrQS, N);
+
+	printf("Proof of corectness adaptive sort:\n");
+	for (int i = 0; i < N; i++) {
+		arrQS[i] = rand() % 100;
+	}
+	showArr(arrQS, N);
+	adaptiveSort(arrQS, 0, N - 1);
+	showArr(arrQS, N);
+
+	printf("Proof of corectness multiselect (ranks 2, 5, 8):\n");
+	for (int i = 0; i < N; i++) {
+		arrQS[i] = rand() % 100;
+	}
+	showArr(arrQS, N);
+	int ranks[] = { 2, 5, 8 };
+	multiSelect(arrQS, 0, N - 1, ranks, 3);
+	showArr(arrQS, N);
+	printf("%d %d %d\n", arrQS[2], arrQS[5], arrQS[8]);
+
+	printf("Proof of corectness top-k (k = 4, streaming):\n");
+	TopKStream<> topK(4);
+	for (int i = 0; i < N; i++) {
+		arrQS[i] = rand() % 100;
+		topK.push(arrQS[i]);
+	}
+	showArr(arrQS, N);
+	topK.result(arrHS);
+	showArr(arrHS, topK.size());
+
     printf("Proof of corectness quickselect:\n");
     showArr(arrQSEL, N);
     quickSelect(arrQSEL, 0, N - 1, N - 1);
@@ -11,6 +11,45 @@
  *      - if a list is empty, we reduce the listNr
  *      - if we only have 2 lists, we use the mergeTwoLists algorithm
  *
+ *   LOSER TREE (mergeKLists, the heap version is kept as mergeKListsHeap):
+ *      - a tournament over the k lists: tree[0] = the list with the minimum first element, every inner node keeps
+ *      the index of the list that lost the match there
+ *      - after the winner gives its element only the matches on its path to the root are played again
+ *      => ceil(log2 k) comparisons per element, no heapify from the root and no struct SLL swaps (only ints move)
+ *      - an empty list loses every match, so nothing has to be removed from the tree
+ *
+ *   ARRAY MERGE (mergeKArrays):
+ *      - the same loser tree over k sorted spans of one contiguous array, each read through a cursor, into an
+ *      output buffer allocated once => no malloc/free per element and sequential memory access
+ *      instead of following pNext pointers
+ *
+ *   NODE POOL (createNode / deleteFirst / deleteList):
+ *      - the nodes are cut from slabs of SLAB_NODES nodes, a freed node goes on a free list and is the next one
+ *      given out => during a merge every deleteFirst hands its node to the next insertAtRear, no malloc/free
+ *      - a whole list goes back to the free list in O(1): its last node is linked to the head of the free list
+ *      - usePool = false (lab04 --malloc) goes back to one malloc/free per node; switch only with no nodes in use
+ *
+ *   PARALLEL MERGE (mergeKArraysParallel, merge path):
+ *      - the output is cut into equal chunks, one per thread; for the first element of every chunk the co-rank
+ *      (how many elements each input gives before it) is found with binary searches over the values and over
+ *      the k inputs => O(32 * k * log(n/k)) per chunk border
+ *      - every thread then merges its k sub-spans with its own loser tree into its own part of the output
+ *      - equal keys are given out in the order of the inputs, so the chunks meet exactly
+ *
+ *   SIMD MERGE (mergeTwoArraysSimd, mergeKArraysPairwise):
+ *      - two sorted inputs are merged 8 ints at a time: a bitonic network (AVX2 min/max + shuffles) merges the
+ *      next block with the 8 largest elements kept in a register and gives out the 8 smallest; the next block comes
+ *      from the input with the smaller head, picked with a select instead of a branch
+ *      - the scalar version is branchless too: one compare per element, the cursors move by the compare result
+ *      (the equal keys need no special case, unlike mergeTwoLists)
+ *      - k inputs are merged in ceil(log2 k) rounds of two-way merges (a tree of pairs)
+ *
+ *   FILE MERGE (mergeKFiles):
+ *      - k sorted files, each read through a buffer of its own, merged with the loser tree of mergeKArrays over the
+ *      heads of the buffers; the output goes through two buffers, one is written by a thread while the
+ *      other is filled => memory = (k + 2) * buffer, the size of the files doesn't matter
+ *      - a read error (ferror, not only a short read) or a failed write makes the merge fail
+ *
  */
 
 #ifdef _MSC_VER
@@ -19,20 +58,87 @@
 
 #include <iostream>
 #include <time.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <limits.h>
 #include "Profiler.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 #define MAXN 10001
 #define MAXK 500
+#define SLAB_NODES 4096
 
 int operations_K = 0;
 
-/// -------------------------------- SLL -----------------------------------------------
+/// -------------------------------- Node pool -----------------------------------------------
 
 struct node {
     int data;
     struct node *pNext;
 };
 
+struct slab {
+    struct slab *pNext;
+    struct node nodes[SLAB_NODES];
+};
+
+struct NodePool {
+    struct slab *pSlabs;        /// all the slabs, the first one is being cut
+    int used;                   /// nodes already cut from the first slab
+    struct node *pFree;         /// freed nodes, reused before cutting new ones
+    int nrSlabs;
+};
+
+bool usePool = true;
+struct NodePool pool = {NULL, SLAB_NODES, NULL, 0};
+
+struct node *poolAlloc() {
+    if(pool.pFree != NULL) {
+        struct node *ptr = pool.pFree;
+        pool.pFree = ptr->pNext;
+        return ptr;
+    }
+    if(pool.used == SLAB_NODES) {
+        struct slab *newSlab = (struct slab*) malloc(sizeof(struct slab));
+        if(newSlab == NULL) {
+            return NULL;
+        }
+        newSlab->pNext = pool.pSlabs;
+        pool.pSlabs = newSlab;
+        pool.used = 0;
+        pool.nrSlabs++;
+    }
+    return &pool.pSlabs->nodes[pool.used++];
+}
+
+void poolFree(struct node *ptr) {
+    ptr->pNext = pool.pFree;
+    pool.pFree = ptr;
+}
+
+/// gives all the slabs back to the system, no node of the pool may be in use anymore
+void poolDestroy() {
+    while(pool.pSlabs != NULL) {
+        struct slab *toDelete = pool.pSlabs;
+        pool.pSlabs = pool.pSlabs->pNext;
+        free(toDelete);
+    }
+    pool.used = SLAB_NODES;
+    pool.pFree = NULL;
+    pool.nrSlabs = 0;
+}
+
+/// -------------------------------- SLL -----------------------------------------------
+
 struct SLL {
     int count;
     struct node *pFirst;
@@ -46,7 +152,7 @@ void createEmptySLL(struct SLL *list) {
 }
 
 struct node *createNode(int data) {
-    struct node *ptr = (struct node*) malloc(sizeof(node));
+    struct node *ptr = usePool ? poolAlloc() : (struct node*) malloc(sizeof(node));
     if(ptr) {
         ptr->data = data;
         ptr->pNext = NULL;
@@ -79,10 +185,27 @@ void deleteFirst(struct SLL *list) {
         node *toDelete = list->pFirst;
         list->pFirst = list->pFirst->pNext;
         list->count--;
-        free(toDelete);
+        if(usePool) {
+            poolFree(toDelete);
+        }
+        else {
+            free(toDelete);
+        }
     }
 }
 
+void deleteList(struct SLL *list) {
+    if(usePool && !isEmpty(*list)) {
+        list->pLast->pNext = pool.pFree;
+        pool.pFree = list->pFirst;
+        createEmptySLL(list);
+    }
+    while(!isEmpty(*list)) {
+        deleteFirst(list);
+    }
+    list->pLast = NULL;
+}
+
 void showList(struct SLL list) {
     struct node *ptr = list.pFirst;
     if(isEmpty(list)) {
@@ -183,7 +306,7 @@ void mergeTwoLists(struct SLL *listOut, struct SLL list1, struct SLL list2) {
     }
 }
 
-void mergeKLists(struct SLL *listOut, struct SLL lists[], int k) {
+void mergeKListsHeap(struct SLL *listOut, struct SLL lists[], int k) {
     int nrLists = k;
     buildHeap(lists, k);
 
@@ -200,6 +323,601 @@ void mergeKLists(struct SLL *listOut, struct SLL lists[], int k) {
     mergeTwoLists(listOut, lists[0], lists[1]);
 }
 
+/// -------------------------------- Loser tree -----------------------------------------------
+
+/// keys[i] = the first element of list i, cached so a match does not follow the list pointers; done[i] = list i is empty
+
+/// true if list a wins the match against list b (smaller first element, an empty list always loses)
+/// the comparison is counted in *ops (operations_K, or a counter of its own for every thread)
+bool beats(const int keys[], const bool done[], int a, int b, int *ops) {
+    if(done[a] || done[b]) {
+        return !done[a];
+    }
+    (*ops)++;
+    return keys[a] < keys[b];
+}
+
+/// the leaves are the nodes k .. 2k - 1 (list = node - k), returns the winner of the subtree of node
+int buildLoserTree(int tree[], const int keys[], const bool done[], int k, int node, int *ops) {
+    if(node >= k) {
+        return node - k;
+    }
+    int left = buildLoserTree(tree, keys, done, k, 2 * node, ops);
+    int right = buildLoserTree(tree, keys, done, k, 2 * node + 1, ops);
+    if(beats(keys, done, left, right, ops)) {
+        tree[node] = right;
+        return left;
+    }
+    tree[node] = left;
+    return right;
+}
+
+/// list winner has a new key (or became empty): plays again the matches on its path to the root
+inline void replayLoserTree(int tree[], const int keys[], const bool done[], int k, int winner, int *ops) {
+    for (int node = (winner + k) / 2; node > 0; node = node / 2) {
+        if(beats(keys, done, tree[node], winner, ops)) {
+            int buff = tree[node];
+            tree[node] = winner;
+            winner = buff;
+        }
+    }
+    tree[0] = winner;
+}
+
+void mergeKLists(struct SLL *listOut, struct SLL lists[], int k) {
+    if(k <= 0) {
+        return;
+    }
+    int *tree = (int*) malloc(k * sizeof(int));
+    int *keys = (int*) malloc(k * sizeof(int));
+    bool *done = (bool*) malloc(k * sizeof(bool));
+    for (int i = 0; i < k; i++) {
+        done[i] = isEmpty(lists[i]);
+        keys[i] = done[i] ? 0 : lists[i].pFirst->data;
+    }
+    tree[0] = buildLoserTree(tree, keys, done, k, 1, &operations_K);
+
+    while(!done[tree[0]]) {
+        int winner = tree[0];
+        insertAtRear(listOut, keys[winner]);
+        operations_K++;
+        deleteFirst(&lists[winner]);
+        if(isEmpty(lists[winner])) {
+            done[winner] = true;
+        }
+        else {
+            keys[winner] = lists[winner].pFirst->data;
+        }
+
+        replayLoserTree(tree, keys, done, k, winner, &operations_K);
+    }
+    free(tree);
+    free(keys);
+    free(done);
+}
+
+/// -------------------------------- Array merge -----------------------------------------------
+
+/// a sorted input read from first up to (not including) last
+struct Span {
+    const int *first;
+    const int *last;
+};
+
+/// out must have room for all the elements of the k spans; the spans are consumed (first == last at the end)
+/// operations are counted in locals (kept in registers, not stored through ops for every element) and added to
+/// *ops once at the end, so the threads of the parallel merge don't write to a shared cache line while merging
+void mergeKArraysCounted(int out[], struct Span spans[], int k, int *ops) {
+    if(k <= 0) {
+        return;
+    }
+    int *tree = (int*) malloc(k * sizeof(int));
+    int *keys = (int*) malloc(k * sizeof(int));
+    bool *done = (bool*) malloc(k * sizeof(bool));
+    for (int i = 0; i < k; i++) {
+        done[i] = spans[i].first == spans[i].last;
+        keys[i] = done[i] ? 0 : *spans[i].first;
+    }
+    int buildOps = 0;
+    int count = 0;
+    tree[0] = buildLoserTree(tree, keys, done, k, 1, &buildOps);
+
+    int outLen = 0;
+    while(!done[tree[0]]) {
+        int winner = tree[0];
+        out[outLen++] = keys[winner];
+        count++;
+        spans[winner].first++;
+        if(spans[winner].first == spans[winner].last) {
+            done[winner] = true;
+        }
+        else {
+            keys[winner] = *spans[winner].first;
+        }
+
+        replayLoserTree(tree, keys, done, k, winner, &count);
+    }
+    *ops = *ops + buildOps + count;
+    free(tree);
+    free(keys);
+    free(done);
+}
+
+void mergeKArrays(int out[], struct Span spans[], int k) {
+    mergeKArraysCounted(out, spans, k, &operations_K);
+}
+
+/// -------------------------------- Parallel merge -----------------------------------------------
+
+/// nr of elements <= value in a sorted span
+int countLessEqual(struct Span span, int value) {
+    const int *lo = span.first;
+    const int *hi = span.last;
+    while(lo < hi) {
+        const int *mid = lo + (hi - lo) / 2;
+        if(*mid <= value) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return (int)(lo - span.first);
+}
+
+/// co-rank: splits[i] = how many elements of span i are among the first rank elements of the merged output
+/// the value of the output element rank - 1 is found by a binary search over the values, then every span gives
+/// its elements < value and the missing ones are taken from the elements == value, in the order of the spans
+void coRank(struct Span spans[], int k, long long rank, int splits[]) {
+    if(rank <= 0) {
+        for (int i = 0; i < k; i++) {
+            splits[i] = 0;
+        }
+        return;
+    }
+    long long lo = INT_MIN;
+    long long hi = INT_MAX;
+    while(lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        long long count = 0;
+        for (int i = 0; i < k; i++) {
+            count = count + countLessEqual(spans[i], (int)mid);
+        }
+        if(count >= rank) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+    int value = (int)lo;
+    long long missing = rank;
+    for (int i = 0; i < k; i++) {
+        splits[i] = value == INT_MIN ? 0 : countLessEqual(spans[i], value - 1);
+        missing = missing - splits[i];
+    }
+    for (int i = 0; i < k && missing > 0; i++) {
+        int equal = countLessEqual(spans[i], value) - splits[i];
+        int taken = (int)(missing < equal ? missing : equal);
+        splits[i] = splits[i] + taken;
+        missing = missing - taken;
+    }
+}
+
+/// the output is cut into nrThreads equal chunks; the co-ranks of the chunk borders give every thread its own
+/// k sub-spans, which it merges with mergeKArraysCounted into its part of out (no synchronization until the join)
+void mergeKArraysParallel(int out[], struct Span spans[], int k, int nrThreads) {
+    long long n = 0;
+    for (int i = 0; i < k; i++) {
+        n = n + (spans[i].last - spans[i].first);
+    }
+    if(nrThreads < 1) {
+        nrThreads = 1;
+    }
+
+    /// splits[t * k + i] = the start of chunk t in span i
+    int *splits = (int*) malloc((size_t)(nrThreads + 1) * k * sizeof(int));
+    for (int t = 0; t <= nrThreads; t++) {
+        coRank(spans, k, n * t / nrThreads, splits + (size_t)t * k);
+    }
+
+    int *ops = (int*) calloc(nrThreads, sizeof(int));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nrThreads; t++) {
+        workers.push_back(std::thread([=]() {
+            struct Span *chunk = (struct Span*) malloc(k * sizeof(struct Span));
+            for (int i = 0; i < k; i++) {
+                chunk[i].first = spans[i].first + splits[(size_t)t * k + i];
+                chunk[i].last = spans[i].first + splits[(size_t)(t + 1) * k + i];
+            }
+            mergeKArraysCounted(out + n * t / nrThreads, chunk, k, &ops[t]);
+            free(chunk);
+        }));
+    }
+    for (int t = 0; t < nrThreads; t++) {
+        workers[t].join();
+        operations_K = operations_K + ops[t];
+    }
+    for (int i = 0; i < k; i++) {
+        spans[i].first = spans[i].last;
+    }
+    free(ops);
+    free(splits);
+}
+
+/// -------------------------------- SIMD two-way merge -----------------------------------------------
+
+/// these merges work on arrays and do not count operations_K
+
+/// branchless: the smaller head is written, the cursor it came from moves by 1 (ties go to a)
+void mergeTwoArraysScalar(int out[], const int a[], int na, const int b[], int nb) {
+    int ia = 0, ib = 0, o = 0;
+    while(ia < na && ib < nb) {
+        int x = a[ia];
+        int y = b[ib];
+        bool takeA = x <= y;
+        out[o++] = takeA ? x : y;
+        ia = ia + takeA;
+        ib = ib + !takeA;
+    }
+    while(ia < na) {
+        out[o++] = a[ia++];
+    }
+    while(ib < nb) {
+        out[o++] = b[ib++];
+    }
+}
+
+#ifdef __AVX2__
+inline __m256i reverse8(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+/// compare-exchange of every lane with its partner lane, the lanes set in Mask keep the max
+template <int Mask>
+inline __m256i compareExchange8(__m256i v, __m256i partner) {
+    return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), Mask);
+}
+
+/// sorts a bitonic register: half-cleaners at distance 4, 2, 1
+inline __m256i bitonicMerge8(__m256i v) {
+    v = compareExchange8<0xF0>(v, _mm256_permute2x128_si256(v, v, 0x01));
+    v = compareExchange8<0xCC>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = compareExchange8<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return v;
+}
+
+/// lo, hi sorted => lo holds the 8 smallest of the 16, hi the 8 largest, both sorted
+inline void bitonicMerge16(__m256i& lo, __m256i& hi) {
+    __m256i rhi = reverse8(hi);
+    __m256i mn = _mm256_min_epi32(lo, rhi);
+    __m256i mx = _mm256_max_epi32(lo, rhi);
+    lo = bitonicMerge8(mn);
+    hi = bitonicMerge8(mx);
+}
+
+/// 8 elements at a time: the register hi keeps the 8 largest seen, the next block of 8 comes from the input
+/// with the smaller head (a select, not a branch) and is merged with hi, the 8 smallest go out
+/// the last < 8 elements of one input are merged with hi first (scalar), then with the rest of the other input
+void mergeTwoArraysSimd(int out[], const int a[], int na, const int b[], int nb) {
+    if(na < 8 || nb < 8) {
+        mergeTwoArraysScalar(out, a, na, b, nb);
+        return;
+    }
+    __m256i lo = _mm256_loadu_si256((const __m256i*)a);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)b);
+    int ia = 8, ib = 8, o = 0;
+    bitonicMerge16(lo, hi);
+    _mm256_storeu_si256((__m256i*)out, lo);
+    o = 8;
+
+    while(ia + 8 <= na && ib + 8 <= nb) {
+        bool takeA = a[ia] <= b[ib];
+        const int *src = takeA ? a + ia : b + ib;
+        ia = ia + 8 * takeA;
+        ib = ib + 8 * !takeA;
+        lo = _mm256_loadu_si256((const __m256i*)src);
+        bitonicMerge16(lo, hi);
+        _mm256_storeu_si256((__m256i*)(out + o), lo);
+        o = o + 8;
+    }
+
+    int rest[8], tail[16];
+    _mm256_storeu_si256((__m256i*)rest, hi);
+    if(na - ia < 8) {
+        mergeTwoArraysScalar(tail, rest, 8, a + ia, na - ia);
+        mergeTwoArraysScalar(out + o, tail, 8 + na - ia, b + ib, nb - ib);
+    }
+    else {
+        mergeTwoArraysScalar(tail, rest, 8, b + ib, nb - ib);
+        mergeTwoArraysScalar(out + o, tail, 8 + nb - ib, a + ia, na - ia);
+    }
+}
+#endif
+
+typedef void (*MergeTwoFunc)(int out[], const int a[], int na, const int b[], int nb);
+
+/// k-way merge as a tree of two-way merges: every round merges neighbouring runs in pairs, ping-ponging between
+/// out and a buffer (the first round reads the spans, the last one writes to out) => ceil(log2 k) passes over n
+void mergeKArraysPairwise(int out[], struct Span spans[], int k, MergeTwoFunc mergeTwo) {
+    if(k <= 0) {
+        return;
+    }
+    int n = 0;
+    int rounds = 0;
+    for (int i = 0; i < k; i++) {
+        n = n + (int)(spans[i].last - spans[i].first);
+    }
+    if(n == 0) {
+        //nothing to merge (and the spans may all be NULL, which memcpy doesn't accept even for 0 bytes)
+        for (int i = 0; i < k; i++) {
+            spans[i].first = spans[i].last;
+        }
+        return;
+    }
+    for (int runs = k; runs > 1; runs = (runs + 1) / 2) {
+        rounds++;
+    }
+    if(rounds == 0) {
+        memcpy(out, spans[0].first, n * sizeof(int));
+        spans[0].first = spans[0].last;
+        return;
+    }
+
+    int *buff = (int*) malloc(n * sizeof(int));
+    /// bounds[i] .. bounds[i + 1] = run i in the buffer written by the last round
+    int *bounds = (int*) malloc((k + 1) * sizeof(int));
+    int *dst = rounds % 2 == 1 ? out : buff;
+    int *src = dst == out ? buff : out;
+
+    int o = 0;
+    int runs = 0;
+    for (int i = 0; i < k; i = i + 2) {
+        bounds[runs++] = o;
+        int na = (int)(spans[i].last - spans[i].first);
+        int nb = i + 1 < k ? (int)(spans[i + 1].last - spans[i + 1].first) : 0;
+        mergeTwo(dst + o, spans[i].first, na, i + 1 < k ? spans[i + 1].first : NULL, nb);
+        o = o + na + nb;
+    }
+    bounds[runs] = n;
+
+    while(runs > 1) {
+        int *buffSwap = src;
+        src = dst;
+        dst = buffSwap;
+        int newRuns = 0;
+        for (int i = 0; i < runs; i = i + 2) {
+            int from = bounds[i];
+            int mid = bounds[i + 1];
+            int to = i + 2 <= runs ? bounds[i + 2] : mid;
+            mergeTwo(dst + from, src + from, mid - from, src + mid, to - mid);
+            bounds[newRuns++] = from;
+        }
+        bounds[newRuns] = n;
+        runs = newRuns;
+    }
+    for (int i = 0; i < k; i++) {
+        spans[i].first = spans[i].last;
+    }
+    free(bounds);
+    free(buff);
+}
+
+/// -------------------------------- File merge -----------------------------------------------
+
+/// sequential reader of a sorted file of ints through a buffer of bufSize ints
+struct FileReader {
+    FILE *file;
+    int *buf;
+    int bufSize;
+    int pos;
+    int len;
+    bool failed;            /// a read error, not the end of the file
+};
+
+void fillReader(struct FileReader *reader) {
+    reader->len = (int) fread(reader->buf, sizeof(int), reader->bufSize, reader->file);
+    reader->pos = 0;
+    if(reader->len < reader->bufSize && ferror(reader->file)) {
+        reader->failed = true;
+    }
+}
+
+bool openReader(struct FileReader *reader, const char *path, int bufSize) {
+    reader->file = fopen(path, "rb");
+    reader->buf = (int*) malloc(bufSize * sizeof(int));
+    reader->bufSize = bufSize;
+    reader->pos = 0;
+    reader->len = 0;
+    reader->failed = false;
+    if(reader->file == NULL || reader->buf == NULL) {
+        return false;
+    }
+    fillReader(reader);
+    return !reader->failed;
+}
+
+bool readerEmpty(struct FileReader *reader) {
+    return reader->pos == reader->len;
+}
+
+int readerKey(struct FileReader *reader) {
+    return reader->buf[reader->pos];
+}
+
+void readerNext(struct FileReader *reader) {
+    reader->pos++;
+    if(reader->pos == reader->len) {
+        fillReader(reader);
+    }
+}
+
+void closeReader(struct FileReader *reader) {
+    if(reader->file != NULL) {
+        fclose(reader->file);
+    }
+    free(reader->buf);
+}
+
+/// double buffered writer: a full buffer is written by its own thread while the merge fills the other one
+struct FileWriter {
+    FILE *file;
+    int *buf[2];
+    int bufSize;
+    int current;            /// the buffer being filled
+    int len;
+    std::thread *pWriting;  /// the thread writing the other buffer, NULL if none
+    bool ok;
+};
+
+bool openWriter(struct FileWriter *writer, const char *path, int bufSize) {
+    writer->file = fopen(path, "wb");
+    writer->buf[0] = (int*) malloc(bufSize * sizeof(int));
+    writer->buf[1] = (int*) malloc(bufSize * sizeof(int));
+    writer->bufSize = bufSize;
+    writer->current = 0;
+    writer->len = 0;
+    writer->pWriting = NULL;
+    writer->ok = writer->file != NULL && writer->buf[0] != NULL && writer->buf[1] != NULL;
+    return writer->ok;
+}
+
+void waitWriter(struct FileWriter *writer) {
+    if(writer->pWriting != NULL) {
+        writer->pWriting->join();
+        delete writer->pWriting;
+        writer->pWriting = NULL;
+    }
+}
+
+void flushWriter(struct FileWriter *writer) {
+    waitWriter(writer);
+    int *full = writer->buf[writer->current];
+    int len = writer->len;
+    writer->pWriting = new std::thread([writer, full, len]() {
+        if(fwrite(full, sizeof(int), len, writer->file) != (size_t) len) {
+            writer->ok = false;
+        }
+    });
+    writer->current = 1 - writer->current;
+    writer->len = 0;
+}
+
+void writerPut(struct FileWriter *writer, int data) {
+    writer->buf[writer->current][writer->len++] = data;
+    if(writer->len == writer->bufSize) {
+        flushWriter(writer);
+    }
+}
+
+bool closeWriter(struct FileWriter *writer) {
+    if(writer->file != NULL && writer->len > 0) {
+        flushWriter(writer);
+    }
+    waitWriter(writer);
+    if(writer->file != NULL && fclose(writer->file) != 0) {
+        writer->ok = false;
+    }
+    free(writer->buf[0]);
+    free(writer->buf[1]);
+    return writer->ok;
+}
+
+/// merges k sorted files into outPath with (k + 2) * bufSize ints of buffers, whatever the size of the files
+/// the loser tree of mergeKArrays, with the keys taken from the buffers of the readers; its comparisons are not
+/// added to operations_K: for files of many GB the count would not fit in an int
+bool mergeKFiles(const char *outPath, const char *inPaths[], int k, int bufSize) {
+    struct FileReader *readers = (struct FileReader*) malloc(k * sizeof(struct FileReader));
+    int *tree = (int*) malloc(k * sizeof(int));
+    int *keys = (int*) malloc(k * sizeof(int));
+    bool *done = (bool*) malloc(k * sizeof(bool));
+    bool ok = k > 0;
+    for (int i = 0; i < k; i++) {
+        if(!openReader(&readers[i], inPaths[i], bufSize)) {
+            printf("can't read %s\n", inPaths[i]);
+            ok = false;
+        }
+        done[i] = readerEmpty(&readers[i]);
+        keys[i] = done[i] ? 0 : readerKey(&readers[i]);
+    }
+
+    struct FileWriter writer;
+    if(ok && !openWriter(&writer, outPath, bufSize)) {
+        printf("can't create %s\n", outPath);
+        closeWriter(&writer);
+        ok = false;
+    }
+    if(ok) {
+        int matches = 0;
+        tree[0] = buildLoserTree(tree, keys, done, k, 1, &matches);
+        while(!done[tree[0]]) {
+            int winner = tree[0];
+            writerPut(&writer, keys[winner]);
+            readerNext(&readers[winner]);
+            if(readerEmpty(&readers[winner])) {
+                done[winner] = true;
+            }
+            else {
+                keys[winner] = readerKey(&readers[winner]);
+            }
+            replayLoserTree(tree, keys, done, k, winner, &matches);
+        }
+        for (int i = 0; i < k; i++) {
+            if(readers[i].failed) {
+                printf("read error in %s, the output is incomplete\n", inPaths[i]);
+                ok = false;
+            }
+        }
+        if(!closeWriter(&writer)) {
+            printf("write to %s failed\n", outPath);
+            ok = false;
+        }
+    }
+
+    for (int i = 0; i < k; i++) {
+        closeReader(&readers[i]);
+    }
+    free(tree);
+    free(keys);
+    free(done);
+    free(readers);
+    return ok;
+}
+
+/// k sorted files prefix0.bin .. prefix(k-1).bin with n elements in total (the values of buildSortedLists)
+bool generateSortedFiles(const char *prefix, int k, long long n) {
+    int block[4096];
+    for (int i = 0; i < k; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s%d.bin", prefix, i);
+        FILE *fout = fopen(path, "wb");
+        if(fout == NULL) {
+            printf("can't create %s\n", path);
+            return false;
+        }
+        long long size = n / k + (i < n % k ? 1 : 0);
+        int value = rand() % 10;
+        while(size > 0) {
+            int len = size < 4096 ? (int) size : 4096;
+            for (int j = 0; j < len; j++) {
+                block[j] = value;
+                value = value + rand() % 10;
+            }
+            if(fwrite(block, sizeof(int), len, fout) != (size_t) len) {
+                printf("write to %s failed\n", path);
+                fclose(fout);
+                return false;
+            }
+            size = size - len;
+        }
+        if(fclose(fout) != 0) {
+            printf("write to %s failed\n", path);
+            return false;
+        }
+    }
+    return true;
+}
+
 //k = nr of lists, n = nr of elements in all the lists
 void buildLists(struct SLL list[], int k, int n) {
     ///because there are k lists with n elements in total, there will be ideally n/k elements in each list
@@ -228,7 +946,330 @@ void buildLists(struct SLL list[], int k, int n) {
 
 }
 
-int main() {
+/// sorted lists without the Profiler (its arrays are limited to MAXN): every list gets n/k (+1) elements
+/// that grow by a random step of 0..9
+void buildSortedLists(struct SLL list[], int k, int n) {
+    for (int i = 0; i < k; i++) {
+        createEmptySLL(&list[i]);
+        int size = n / k + (i < n % k ? 1 : 0);
+        int value = rand() % 10;
+        for (int j = 0; j < size; j++) {
+            insertAtRear(&list[i], value);
+            value = value + rand() % 10;
+        }
+    }
+}
+
+/// the same values as buildSortedLists for the same seed, list i in data[spans[i].first .. spans[i].last)
+void buildSortedArrays(int data[], struct Span spans[], int k, int n) {
+    int pos = 0;
+    for (int i = 0; i < k; i++) {
+        int size = n / k + (i < n % k ? 1 : 0);
+        spans[i].first = data + pos;
+        int value = rand() % 10;
+        for (int j = 0; j < size; j++) {
+            data[pos++] = value;
+            value = value + rand() % 10;
+        }
+        spans[i].last = data + pos;
+    }
+}
+
+bool isSortedList(struct SLL list) {
+    for (struct node *ptr = list.pFirst; ptr != NULL && ptr->pNext != NULL; ptr = ptr->pNext) {
+        if(ptr->pNext->data < ptr->data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef void (*MergeFunc)(struct SLL *listOut, struct SLL lists[], int k);
+
+/// lab4_bench.csv: operations and time of the heap and the loser tree merge of lists, and of the loser tree merge
+/// of arrays, for k = 2 .. 10^4 inputs, n elements in total (the same values for all three)
+void runBenchmarks(int n) {
+    FILE* fout;
+    fout = fopen("lab4_bench.csv", "w+");
+    fprintf(fout, "K,N,Merge,Operations,ms\n");
+
+    const char* mergeNames[] = {"heap", "loser tree"};
+    MergeFunc merges[] = {mergeKListsHeap, mergeKLists};
+    int ks[] = {2, 4, 8, 16, 64, 256, 1000, 4096, 10000};
+
+    struct SLL *lists = (struct SLL*) malloc(10000 * sizeof(struct SLL));
+    struct SLL listOut;
+    struct Span *spans = (struct Span*) malloc(10000 * sizeof(struct Span));
+    int *data = (int*) malloc(n * sizeof(int));
+    int *out = (int*) malloc(n * sizeof(int));
+    for (int k : ks) {
+        for (int m = 0; m < 2; m++) {
+            srand(k);
+            buildSortedLists(lists, k, n);
+            createEmptySLL(&listOut);
+            operations_K = 0;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            merges[m](&listOut, lists, k);
+            std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+            if(listOut.count != n || !isSortedList(listOut)) {
+                printf("%s merge is wrong for k = %d\n", mergeNames[m], k);
+            }
+            fprintf(fout, "%d,%d,%s,%d,%.3f\n", k, n, mergeNames[m], operations_K, ms);
+            printf("k = %5d %-10s %10d operations %10.3f ms\n", k, mergeNames[m], operations_K, ms);
+            /// the merges free the nodes of the input lists as they go
+            deleteList(&listOut);
+        }
+
+        srand(k);
+        buildSortedArrays(data, spans, k, n);
+        operations_K = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        mergeKArrays(out, spans, k);
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        for (int i = 1; i < n; i++) {
+            if(out[i] < out[i - 1]) {
+                printf("array merge is wrong for k = %d\n", k);
+                break;
+            }
+        }
+        fprintf(fout, "%d,%d,%s,%d,%.3f\n", k, n, "arrays", operations_K, ms);
+        printf("k = %5d %-10s %10d operations %10.3f ms\n", k, "arrays", operations_K, ms);
+    }
+    free(lists);
+    free(spans);
+    free(data);
+    free(out);
+    fclose(fout);
+}
+
+/// lab4_parallel.csv: the parallel array merge at 1, 2, 4, ... maxThreads threads, k of the P2 experiment, n elements
+void runParallelBenchmark(int n, int maxThreads) {
+    FILE* fout;
+    fout = fopen("lab4_parallel.csv", "w+");
+    fprintf(fout, "K,N,Threads,ms,Speedup\n");
+
+    int ks[] = {10, 100, 500};
+    struct Span *spans = (struct Span*) malloc(500 * sizeof(struct Span));
+    int *data = (int*) malloc(n * sizeof(int));
+    int *out = (int*) malloc(n * sizeof(int));
+    int *expected = (int*) malloc(n * sizeof(int));
+    /// the page faults of the first write to out would otherwise be timed with the 1 thread run only
+    memset(out, 0, n * sizeof(int));
+    for (int k : ks) {
+        srand(k);
+        buildSortedArrays(data, spans, k, n);
+        mergeKArrays(expected, spans, k);
+
+        double oneThreadMs = 0;
+        for (int t = 1; t <= maxThreads; t = t * 2) {
+            srand(k);
+            buildSortedArrays(data, spans, k, n);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            mergeKArraysParallel(out, spans, k, t);
+            std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+            if(t == 1) {
+                oneThreadMs = ms;
+            }
+            if(memcmp(out, expected, n * sizeof(int)) != 0) {
+                printf("parallel merge is wrong for k = %d, %d threads\n", k, t);
+            }
+            fprintf(fout, "%d,%d,%d,%.3f,%.2f\n", k, n, t, ms, oneThreadMs / ms);
+            printf("k = %3d threads = %2d %10.3f ms speedup %.2f\n", k, t, ms, oneThreadMs / ms);
+        }
+    }
+    free(spans);
+    free(data);
+    free(out);
+    free(expected);
+    fclose(fout);
+}
+
+/// lab4_simd.csv: elements/second of the two-way merges (k = 2) and of the pairwise k-way merge with the scalar
+/// and the AVX2 kernel, next to the loser tree of mergeKArrays
+void runSimdBenchmark(int n) {
+    FILE* fout;
+    fout = fopen("lab4_simd.csv", "w+");
+    fprintf(fout, "K,N,Merge,ms,M elements/s\n");
+
+    const char* mergeNames[] = {"pairwise scalar", "pairwise avx2", "loser tree"};
+    int ks[] = {2, 4, 16, 64, 256, 1000};
+    struct Span *spans = (struct Span*) malloc(1000 * sizeof(struct Span));
+    int *data = (int*) malloc(n * sizeof(int));
+    int *out = (int*) malloc(n * sizeof(int));
+    int *expected = (int*) malloc(n * sizeof(int));
+    for (int k : ks) {
+        srand(k);
+        buildSortedArrays(data, spans, k, n);
+        mergeKArrays(expected, spans, k);
+        for (int m = 0; m < 3; m++) {
+#ifndef __AVX2__
+            if(m == 1) {
+                printf("built without AVX2, no simd merge\n");
+                continue;
+            }
+#endif
+            srand(k);
+            buildSortedArrays(data, spans, k, n);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(m == 0) {
+                mergeKArraysPairwise(out, spans, k, mergeTwoArraysScalar);
+            }
+#ifdef __AVX2__
+            else if(m == 1) {
+                mergeKArraysPairwise(out, spans, k, mergeTwoArraysSimd);
+            }
+#endif
+            else {
+                mergeKArrays(out, spans, k);
+            }
+            std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+            if(memcmp(out, expected, n * sizeof(int)) != 0) {
+                printf("%s merge is wrong for k = %d\n", mergeNames[m], k);
+            }
+            fprintf(fout, "%d,%d,%s,%.3f,%.1f\n", k, n, mergeNames[m], ms, n / ms / 1000.0);
+            printf("k = %4d %-16s %10.3f ms %8.1f M elements/s\n", k, mergeNames[m], ms, n / ms / 1000.0);
+        }
+    }
+    free(spans);
+    free(data);
+    free(out);
+    free(expected);
+    fclose(fout);
+}
+
+/// resident set size of the process in KB, -1 where it can't be read
+long currentRSSKB() {
+#ifdef __linux__
+    long pages = -1;
+    FILE* fin = fopen("/proc/self/statm", "r");
+    if(fin != NULL) {
+        if(fscanf(fin, "%*s %ld", &pages) != 1) {
+            pages = -1;
+        }
+        fclose(fin);
+    }
+    return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
+
+/// the lists of the P1 (k = 5, 10, 100, n = 400 .. 4000) and P2 (k = 10 .. 500, n = 10000) experiments, and one
+/// with 10^7 elements in 1000 lists, built, merged and released with the allocator chosen by usePool
+/// times are summed over all the n (or k) of an experiment, RSS is taken after the last merge, before the release
+void runAllocExperiment(FILE* fout, const char* name, int kFrom, int kTo, int kStep, int nFrom, int nTo, int nStep) {
+    struct SLL *lists = (struct SLL*) malloc(kTo * sizeof(struct SLL));
+    struct SLL listOut;
+    double buildMs = 0, mergeMs = 0, releaseMs = 0;
+    long rss = 0;
+    for (int k = kFrom; k <= kTo; k = k + kStep) {
+        for (int n = nFrom; n <= nTo; n = n + nStep) {
+            srand(k + n);
+            createEmptySLL(&listOut);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            buildSortedLists(lists, k, n);
+            std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+            mergeKLists(&listOut, lists, k);
+            std::chrono::steady_clock::time_point merged = std::chrono::steady_clock::now();
+            rss = currentRSSKB();
+            deleteList(&listOut);
+            std::chrono::steady_clock::time_point released = std::chrono::steady_clock::now();
+
+            buildMs = buildMs + std::chrono::duration<double, std::milli>(built - start).count();
+            mergeMs = mergeMs + std::chrono::duration<double, std::milli>(merged - built).count();
+            releaseMs = releaseMs + std::chrono::duration<double, std::milli>(released - merged).count();
+        }
+    }
+    free(lists);
+    fprintf(fout, "%s,%s,%.3f,%.3f,%.3f,%ld\n", name, usePool ? "pool" : "malloc", buildMs, mergeMs, releaseMs, rss);
+    printf("%-14s %-6s build %9.3f ms merge %9.3f ms release %9.3f ms RSS %ld KB\n", name,
+           usePool ? "pool" : "malloc", buildMs, mergeMs, releaseMs, rss);
+}
+
+/// lab4_alloc.csv: malloc per node vs the node pool
+void runAllocBenchmark() {
+    FILE* fout;
+    fout = fopen("lab4_alloc.csv", "w+");
+    fprintf(fout, "Experiment,Allocator,Build ms,Merge ms,Release ms,RSS KB\n");
+
+    /// the pool first: the chunks that free keeps after the malloc run would be reused by the slabs
+    /// (and RSS does not go down between the runs, the heap is not given back to the system)
+    bool pooled[] = {true, false};
+    for (bool p : pooled) {
+        usePool = p;
+        runAllocExperiment(fout, "P1 k=5", 5, 5, 1, 400, 4000, 400);
+        runAllocExperiment(fout, "P1 k=10", 10, 10, 1, 400, 4000, 400);
+        runAllocExperiment(fout, "P1 k=100", 100, 100, 1, 400, 4000, 400);
+        runAllocExperiment(fout, "P2", 10, 500, 10, 10000, 10000, 1);
+        runAllocExperiment(fout, "k=1000 n=10^7", 1000, 1000, 1, 10000000, 10000000, 1);
+        poolDestroy();
+    }
+    usePool = true;
+    fclose(fout);
+}
+
+int main(int argc, char* argv[]) {
+    /// lab04 --malloc ...: one malloc/free per node instead of the node pool
+    if(argc > 1 && strcmp(argv[1], "--malloc") == 0) {
+        usePool = false;
+        argc--;
+        argv++;
+    }
+    /// lab04 --parallel [n] [maxThreads]: the parallel array merge (default 10^7 elements, up to the nr of cores)
+    if(argc > 1 && strcmp(argv[1], "--parallel") == 0) {
+        int cores = (int)std::thread::hardware_concurrency();
+        runParallelBenchmark(argc > 2 ? atoi(argv[2]) : 10000000, argc > 3 ? atoi(argv[3]) : (cores > 0 ? cores : 1));
+        return 0;
+    }
+    /// lab04 --simd [n]: scalar vs AVX2 two-way merge kernels in a pairwise k-way merge (default 10^7 elements)
+    if(argc > 1 && strcmp(argv[1], "--simd") == 0) {
+        runSimdBenchmark(argc > 2 ? atoi(argv[2]) : 10000000);
+        return 0;
+    }
+    /// lab04 --genfiles prefix k n: k sorted files prefix0.bin .. with n ints in total
+    if(argc > 4 && strcmp(argv[1], "--genfiles") == 0) {
+        return generateSortedFiles(argv[2], atoi(argv[3]), atoll(argv[4])) ? 0 : 1;
+    }
+    /// lab04 --mergefiles out bufKB in1 in2 ...: merges the sorted files with a buffer of bufKB per file
+    if(argc > 4 && strcmp(argv[1], "--mergefiles") == 0) {
+        int k = argc - 4;
+        int bufSize = atoi(argv[3]) * 1024 / (int) sizeof(int);
+        if(bufSize < 1) {
+            bufSize = 1;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool ok = mergeKFiles(argv[2], (const char**) (argv + 4), k, bufSize);
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(stop - start).count();
+        FILE *fin = fopen(argv[2], "rb");
+        long long bytes = 0;
+        if(fin != NULL) {
+            fseek(fin, 0, SEEK_END);
+            bytes = ftell(fin);
+            fclose(fin);
+        }
+        printf("%d files, %.1f MB in %.3f s = %.1f MB/s, buffers %lld KB\n", k,
+               bytes / (1024.0 * 1024.0), sec, bytes / (1024.0 * 1024.0) / sec,
+               (long long) (k + 2) * bufSize * (long long) sizeof(int) / 1024);
+        return ok ? 0 : 1;
+    }
+    /// lab04 --alloc: time and RSS of the list experiments with malloc and with the node pool
+    if(argc > 1 && strcmp(argv[1], "--alloc") == 0) {
+        runAllocBenchmark();
+        return 0;
+    }
+    /// lab04 --bench [n]: heap vs loser tree merge of lists vs merge of arrays, n elements in total (default 10^7)
+    if(argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        runBenchmarks(argc > 2 ? atoi(argv[2]) : 10000000);
+        return 0;
+    }
+
     FILE* fout;
     fout = fopen("lab4.csv", "w+");
 
@@ -243,6 +1284,7 @@ int main() {
     printf("The merged list:\n");
     mergeKLists(&listOut, lists, 4);
     showList(listOut);
+    deleteList(&listOut);
 
     ///------------------------------- P1 -----------------------------------------------
     /// k = 5
@@ -254,6 +1296,7 @@ int main() {
         buildLists(lists, 5, n);
         mergeKLists(&listOut, lists, 5);
         fprintf(fout, "%d\n", operations_K);
+        deleteList(&listOut);
         operations_K = 0;
     }
 
@@ -266,6 +1309,7 @@ int main() {
         buildLists(lists, 10, n);
         mergeKLists(&listOut, lists, 10);
         fprintf(fout, "%d\n", operations_K);
+        deleteList(&listOut);
         operations_K = 0;
     }
 
@@ -278,6 +1322,7 @@ int main() {
         buildLists(lists, 100, n);
         mergeKLists(&listOut, lists, 100);
         fprintf(fout, "%d\n", operations_K);
+        deleteList(&listOut);
         operations_K = 0;
     }
 
@@ -290,6 +1335,7 @@ int main() {
         buildLists(lists, k, 10000);
         mergeKLists(&listOut, lists, k);
         fprintf(fout, "%d\n", operations_K);
+        deleteList(&listOut);
         operations_K = 0;
     }
     return 0;
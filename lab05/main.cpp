@@ -7,6 +7,13 @@
  *      This is because it doesn't find and empty position, thus it runs until i = TABLE_SIZE, making some searches O(TABLE_SIZE)
  *      - searching effort depends on the hash function
  *
+ *      SoA (HashTableSoA, lab05 --soa):
+ *      - the ids are kept in a dense array of their own, the names in a second one that is touched only on a hit
+ *      => a probe reads 4 bytes instead of a 36 byte Entry, 16 ids per cache line instead of less than 2
+ *      - the probe sequence is the same (hashQuadratic), so the effort is the same, only the ns per lookup change
+ *      - lab5_soa.csv: effort and ns per lookup of both layouts, for TABLE_SIZE and for a table of 10^6 slots
+ *      that doesn't fit in the cache as an array of Entry
+ *
 */
 
 #ifdef _MSC_VER
@@ -16,9 +23,14 @@
 #include <iostream>
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <algorithm>
 #include "Profiler.h"
 
 #define TABLE_SIZE 9973
+#define BIG_TABLE_SIZE 1000003
+#define LOOKUP_RUNS 20
 
 int nrSearch = 0;
 
@@ -39,7 +51,8 @@ int hashFunc(int id, int n) {
 }
 
 int hashQuadratic(int id, int i, int n) {
-    return ( (hashFunc(id, n) + i + (i * i)) % n );
+    /// in long long: i * i overflows an int after i = 46340, which a table of BIG_TABLE_SIZE can reach
+    return (int) ( ((long long) hashFunc(id, n) + i + (long long) i * i) % n );
 }
 
 bool insertElement(Entry hashTable[], int id, int n) {
@@ -105,13 +118,187 @@ bool searchElementDemo(Entry hashTable[], int id, int n) {
 }
 
 
+/// -------------------------------- SoA -----------------------------------------------
+
+typedef struct {
+    int *ids;               /// probed, -1 = empty
+    char (*names)[30];      /// payload, names[pos] belongs to ids[pos]
+    int n;
+} HashTableSoA;
+
+bool hashTableInitSoA(HashTableSoA *table, int n) {
+    table->ids = (int*) malloc(n * sizeof(int));
+    table->names = (char(*)[30]) malloc(n * sizeof(*table->names));
+    table->n = n;
+    if(table->ids == NULL || table->names == NULL) {
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        table->ids[i] = -1;
+        strcpy(table->names[i], "Empty");
+    }
+    return true;
+}
+
+void hashTableFreeSoA(HashTableSoA *table) {
+    free(table->ids);
+    free(table->names);
+}
+
+bool insertElementSoA(HashTableSoA *table, int id, const char name[30]) {
+    int i = 0;
+    while (i < table->n) {
+        int pos = hashQuadratic(id, i, table->n);
+        if(table->ids[pos] == -1) {
+            table->ids[pos] = id;
+            strcpy(table->names[pos], name);
+            return true;
+        }
+        i++;
+    }
+    return false;
+}
+
+/// the name of id, NULL if it is not in the table; only the ids are read while probing
+const char *searchElementSoA(HashTableSoA *table, int id) {
+    int i = 0;
+    while(i < table->n) {
+        nrSearch++;
+
+        int pos = hashQuadratic(id, i, table->n);
+        if(table->ids[pos] == -1)
+            return NULL;
+        if (table->ids[pos] == id)
+            return table->names[pos];
+        i++;
+    }
+    return NULL;
+}
+
 void showHashTable(Entry hashTable[], int n) {
     for (int i = 0; i < n; i++) {
         printf("%d element: id = %d, name = %s\n", i+1, hashTable[i].id, hashTable[i].name);
     }
 }
 
-int main() {
+/// the same ids in both layouts: nrElem ids from 1 .. 5 * n, 1500 of them searched (found) and 1500 ids above
+/// 5 * n (not found); effort = probes per search, time = median of LOOKUP_RUNS passes over the 3000 searches
+bool runLayoutExperiment(FILE* fout, int n, float fillingFactor) {
+    int nrElem = (int) (fillingFactor * n);
+    int *arr = (int*) malloc(nrElem * sizeof(int));
+    Entry *hashTable = (Entry*) malloc(n * sizeof(Entry));
+    HashTableSoA tableSoA;
+    bool ok = hashTableInitSoA(&tableSoA, n) && arr != NULL && hashTable != NULL;
+    if(!ok) {
+        printf("can't allocate the tables of %d elements\n", n);
+    }
+    else {
+        FillRandomArray(arr, nrElem, 1, 5 * n, true, 0);
+        hashTableInit(hashTable, n);
+        for (int j = 0; j < nrElem && ok; j++) {
+            if(!insertElement(hashTable, arr[j], n) || !insertElementSoA(&tableSoA, arr[j], "name")) {
+                printf("%d not added, table size %d, filling factor %f\n", arr[j], n, fillingFactor);
+                ok = false;
+            }
+        }
+    }
+    if(!ok) {
+        hashTableFreeSoA(&tableSoA);
+        free(hashTable);
+        free(arr);
+        return false;
+    }
+
+    int found[1500], notFound[1500];
+    for (int j = 0; j < 1500; j++) {
+        found[j] = arr[j * (nrElem / 1500)];
+        notFound[j] = 5 * n + 1 + 50 * j;
+    }
+
+    const char* layoutNames[] = {"AoS", "SoA"};
+    for (int layout = 0; layout < 2; layout++) {
+        int *ids[] = {found, notFound};
+        float avgEffort[2], maxEffort[2];
+        double nsPerLookup[2];
+        for (int kind = 0; kind < 2; kind++) {
+            float total = 0;
+            int maxSearch = 0;
+            for (int j = 0; j < 1500; j++) {
+                nrSearch = 0;
+                if(layout == 0) {
+                    searchElement(hashTable, ids[kind][j], n);
+                }
+                else {
+                    searchElementSoA(&tableSoA, ids[kind][j]);
+                }
+                total = total + (float) nrSearch;
+                if(nrSearch > maxSearch) {
+                    maxSearch = nrSearch;
+                }
+            }
+            avgEffort[kind] = total / 1500;
+            maxEffort[kind] = (float) maxSearch;
+
+            double ns[LOOKUP_RUNS];
+            int hits = 0;
+            for (int r = 0; r < LOOKUP_RUNS; r++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int j = 0; j < 1500; j++) {
+                    if(layout == 0) {
+                        hits = hits + searchElement(hashTable, ids[kind][j], n);
+                    }
+                    else {
+                        hits = hits + (searchElementSoA(&tableSoA, ids[kind][j]) != NULL);
+                    }
+                }
+                std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+                ns[r] = std::chrono::duration<double, std::nano>(stop - start).count() / 1500;
+            }
+            if(hits != (kind == 0 ? 1500 * LOOKUP_RUNS : 0)) {
+                printf("%s search is wrong\n", layoutNames[layout]);
+            }
+            std::sort(ns, ns + LOOKUP_RUNS);
+            nsPerLookup[kind] = ns[LOOKUP_RUNS / 2];
+        }
+        fprintf(fout, "%d,%f,%s,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f\n", n, fillingFactor, layoutNames[layout],
+                avgEffort[0], maxEffort[0], avgEffort[1], maxEffort[1], nsPerLookup[0], nsPerLookup[1]);
+    }
+
+    hashTableFreeSoA(&tableSoA);
+    free(hashTable);
+    free(arr);
+    return true;
+}
+
+/// lab5_soa.csv: array of Entry vs SoA
+void runLayoutBenchmark() {
+    FILE* fout;
+    fout = fopen("lab5_soa.csv", "w+");
+    fprintf(fout, "Table Size,Filling Factor,Layout,Avg Effort found,Max Effort found,Avg Effort not-found,"
+                  "Max Effort not-found,ns found,ns not-found\n");
+
+    int tableSizes[] = {TABLE_SIZE, BIG_TABLE_SIZE};
+    float fillingFactor[] = {0.8, 0.85, 0.9, 0.95, 0.99};
+    srand((unsigned int)time(NULL));
+    for (int n : tableSizes) {
+        for (float i : fillingFactor) {
+            if(!runLayoutExperiment(fout, n, i)) {
+                printf("experiment aborted\n");
+                fclose(fout);
+                return;
+            }
+        }
+    }
+    fclose(fout);
+}
+
+int main(int argc, char* argv[]) {
+    /// lab05 --soa: the Entry array vs the SoA layout, writes lab5_soa.csv
+    if(argc > 1 && strcmp(argv[1], "--soa") == 0) {
+        runLayoutBenchmark();
+        return 0;
+    }
+
     /// Proof of Corectness
     printf("Proof of corectness:\n");
     Entry hashTableDemo[5];